@@ -1,5 +1,5 @@
 // FILE: shaders/particle-lenia/2d/fields_2d.frag
-// this file get's prefixed with fields_functions_2d.glsl
+// this file get's prefixed with fields_functions_2d.glsl and fields_functions.glsl
 
 out vec4 FragColor;
 in vec2 TexCoord;
@@ -26,13 +26,25 @@ uniform vec4 color2 = vec4(241.0 / 255., 143.0 / 255., 1.0 / 255., 1.0);
 // select fields to display
 // 0: none
 // 1: U, 2: R, 3: G, 4: E
+#ifdef SPECIALIZED
+const int render_1 = SPECIALIZED_RENDER_1;
+const int render_2 = SPECIALIZED_RENDER_2;
+#else
 uniform int render_1 = -1;
 uniform int render_2 = -1;
+#endif
 
 // translate information
 uniform float translate_x;
 uniform float translate_y;
 
+// U, dU/dx, dU/dy and R at the points of a particle mesh computed on the cpu
+uniform bool use_mesh = false;
+uniform sampler2D mesh_fields;
+uniform float mesh_origin_x;
+uniform float mesh_origin_y;
+uniform float mesh_spacing;
+
 vec4 blend(vec4 color1, vec4 color2, float amount) {
     return (1.0 - amount) * color1 + amount * color2;
 }
@@ -41,6 +53,24 @@ float norm_squared(vec2 vector) {
     return vector.x * vector.x + vector.y * vector.y;
 }
 
+// interpolates U and R bilinearly between the mesh points, like the cpu does, and derives G and E from them
+vec4 mesh_fields_at(vec2 position) {
+    vec2 grid_position = (position - vec2(mesh_origin_x, mesh_origin_y)) / mesh_spacing;
+    ivec2 size = textureSize(mesh_fields, 0);
+    // everything outside of the mesh is further than the cutoff radius away from all particles
+    if (any(lessThan(grid_position, vec2(0.0))) || any(greaterThanEqual(grid_position, vec2(size - 1)))) {
+        return vec4(0.0, 0.0, G(0.0), E(0.0, G(0.0)));
+    }
+    ivec2 cell = ivec2(grid_position);
+    vec2 fraction = grid_position - vec2(cell);
+    vec4 bottom = mix(texelFetch(mesh_fields, cell, 0), texelFetch(mesh_fields, cell + ivec2(1, 0), 0), fraction.x);
+    vec4 top = mix(texelFetch(mesh_fields, cell + ivec2(0, 1), 0), texelFetch(mesh_fields, cell + ivec2(1, 1), 0),
+                   fraction.x);
+    vec4 values = mix(bottom, top, fraction.y);
+    float g = G(values.x);
+    return vec4(values.x, values.a, g, E(values.a, g));
+}
+
 void main()
 {
     float x = (TexCoord.x - 0.5) * 2 * internal_width + translate_x;
@@ -52,7 +82,7 @@ void main()
         FragColor = background_color;
     } else {
 
-        vec4 fields = fields(vec2(x, y));
+        vec4 fields = use_mesh ? mesh_fields_at(position) : fields(position);
 
         float value_1 = 0.0;
         switch (render_1) {
@@ -95,11 +125,25 @@ void main()
         );
     }
 
-    for (int i = 0; i < num_particles; ++i) {
-        float distance = norm_squared(particles[i] - position);
-        if (distance < 0.01) {
-            FragColor = vec4(1.0, 1.0, 1.0, 1.0);
-            break;
+    if (use_grid) {
+        uint cells[NEIGHBOUR_CELLS];
+        int num_cells = neighbour_cells(position, cells);
+        for (int c = 0; c < num_cells; ++c) {
+            uint end = cell_start[cells[c]] + cell_count[cells[c]];
+            for (uint i = cell_start[cells[c]]; i < end; ++i) {
+                if (norm_squared(sorted_particles[i] - position) < 0.01) {
+                    FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+                    break;
+                }
+            }
+        }
+    } else {
+        for (int i = 0; i < num_particles; ++i) {
+            float distance = norm_squared(particles[i] - position);
+            if (distance < 0.01) {
+                FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+                break;
+            }
         }
     }
 }
\ No newline at end of file
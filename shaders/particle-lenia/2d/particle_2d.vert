@@ -1,11 +1,5 @@
 // FILE: shaders/particle-lenia/2d/particle_2d.vert
-// this file get's prefixed with fields_functions_2d.glsl
-
-// value for gradient calculations
-uniform float h;
-uniform float h2;
-// time step size
-uniform float dt;
+// this file get's prefixed with fields_functions_2d.glsl and fields_functions.glsl
 
 uniform float translate_x;
 uniform float translate_y;
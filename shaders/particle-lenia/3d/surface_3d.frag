@@ -0,0 +1,12 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec3 normal;
+
+uniform vec4 surface_color = vec4(0.9, 0.6, 0.2, 1.0);
+
+void main() {
+    // lit from the viewer, from both sides since the view can look into the surface at the border of the volume
+    float light = 0.25 + 0.75 * abs(normalize(normal).z);
+    FragColor = vec4(surface_color.rgb * light, surface_color.a);
+}
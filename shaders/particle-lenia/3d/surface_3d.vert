@@ -0,0 +1,28 @@
+// FILE: shaders/particle-lenia/3d/surface_3d.vert
+#version 430 core
+// the arguments get inserted after the version line
+
+// draws the triangles appended by marching_cubes.comp, with the view of particle_3d.vert
+
+uniform vec3 scale;
+uniform vec3 translate;
+uniform mat3 rotation;
+
+struct Vertex {
+    vec4 position;
+    vec4 normal;
+};
+
+layout (std430) restrict readonly buffer SurfaceBuffer {
+    Vertex vertices[];
+};
+
+out vec3 normal;
+
+void main()
+{
+    Vertex vertex = vertices[gl_VertexID];
+
+    gl_Position = vec4((rotation * (vertex.position.xyz - translate)) * scale, 1.0);
+    normal = rotation * vertex.normal.xyz;
+}
@@ -0,0 +1,103 @@
+// FILE: shaders/particle-lenia/3d/volume_3d.frag
+#version 430 core
+// the arguments get inserted after the version line
+
+// composites the field volume written by field_volume.comp along a ray per pixel, front to back
+// the view is the orthographic one of particle_3d.vert, the ray of a pixel crosses clip space from z = -1 to z = 1
+
+out vec4 FragColor;
+in vec2 TexCoord;
+
+uniform vec3 scale;
+uniform vec3 translate;
+uniform mat3 rotation;
+
+// u, r, g, e per voxel, filtered linearly
+uniform sampler3D field_volume;
+// corner of the volume and its edge length
+uniform vec3 volume_origin;
+uniform float volume_extent;
+// number of samples along a ray through the whole volume
+uniform int ray_steps = 128;
+
+uniform vec4 background_color = vec4(1 / 255., 23 / 255., 47 / 255., 1.0);
+uniform vec4 color1 = vec4(46 / 255., 134 / 255., 171 / 255., 1.0);
+uniform vec4 color2 = vec4(241.0 / 255., 143.0 / 255., 1.0 / 255., 1.0);
+
+// select fields to display
+// 0: none
+// 1: U, 2: R, 3: G, 4: E
+uniform int render_1 = -1;
+uniform int render_2 = -1;
+
+// transfer functions: a field value is transparent below low, fully covered at high and smoothly in between,
+// the opacity is that coverage times the opacity per unit length
+uniform float low_1 = 0.0;
+uniform float high_1 = 1.0;
+uniform float opacity_1 = 1.0;
+uniform float low_2 = 0.0;
+uniform float high_2 = 1.0;
+uniform float opacity_2 = 1.0;
+
+// the rays stop once they are this opaque
+const float OPAQUE = 0.99;
+
+float field_value(vec4 fields, int render) {
+    switch (render) {
+        case 1:
+            return fields.x;
+        case 2:
+            return fields.y;
+        case 3:
+            return fields.z;
+        case 4:
+            return abs(fields.a);
+    }
+    return 0.0;
+}
+
+// colour and opacity of one sample, the opacity corrected for the distance to the next sample
+vec4 classify(vec4 fields, float step_length) {
+    float coverage_1 = render_1 > 0 ? smoothstep(low_1, high_1, field_value(fields, render_1)) : 0.0;
+    float coverage_2 = render_2 > 0 ? smoothstep(low_2, high_2, field_value(fields, render_2)) : 0.0;
+    float alpha_1 = 1.0 - exp(-opacity_1 * coverage_1 * step_length);
+    float alpha_2 = 1.0 - exp(-opacity_2 * coverage_2 * step_length);
+    float alpha = 1.0 - (1.0 - alpha_1) * (1.0 - alpha_2);
+    if (alpha <= 0.0) return vec4(0.0);
+    vec3 color = (alpha_1 * color1.rgb + alpha_2 * color2.rgb) / (alpha_1 + alpha_2);
+    return vec4(color, alpha);
+}
+
+// inverse of the transformation in particle_3d.vert
+vec3 world_position(vec3 clip) {
+    return transpose(rotation) * (clip / scale) + translate;
+}
+
+void main()
+{
+    vec2 pixel = TexCoord * 2.0 - 1.0;
+    vec3 ray_start = world_position(vec3(pixel, -1.0));
+    vec3 ray = world_position(vec3(pixel, 1.0)) - ray_start;
+
+    // intersection of the ray with the box of the volume, as fractions of the ray
+    // components of 0 would turn the slab test into 0 * inf
+    vec3 inverse_ray = 1.0 / mix(ray, vec3(1e-12), equal(ray, vec3(0.0)));
+    vec3 t_0 = (volume_origin - ray_start) * inverse_ray;
+    vec3 t_1 = (volume_origin + volume_extent - ray_start) * inverse_ray;
+    float t_enter = max(max(max(min(t_0.x, t_1.x), min(t_0.y, t_1.y)), min(t_0.z, t_1.z)), 0.0);
+    float t_exit = min(min(min(max(t_0.x, t_1.x), max(t_0.y, t_1.y)), max(t_0.z, t_1.z)), 1.0);
+
+    vec4 accumulated = vec4(0.0);
+    if (t_enter < t_exit && (render_1 > 0 || render_2 > 0)) {
+        float ray_length = length(ray);
+        // the same sample spacing for all rays, ray_steps of them span the volume
+        float step_t = volume_extent / (float(ray_steps) * ray_length);
+        for (float t = t_enter + 0.5 * step_t; t < t_exit && accumulated.a < OPAQUE; t += step_t) {
+            vec3 coordinates = (ray_start + t * ray - volume_origin) / volume_extent;
+            vec4 sample_color = classify(texture(field_volume, coordinates), step_t * ray_length);
+            accumulated.rgb += (1.0 - accumulated.a) * sample_color.a * sample_color.rgb;
+            accumulated.a += (1.0 - accumulated.a) * sample_color.a;
+        }
+    }
+    FragColor = vec4(accumulated.rgb + (1.0 - accumulated.a) * background_color.rgb, 1.0);
+}
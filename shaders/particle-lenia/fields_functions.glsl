@@ -0,0 +1,144 @@
+// FILE: shaders/particle-lenia/fields_functions.glsl
+// field functions of both dimensions, this file gets put after fields_functions_2d.glsl or fields_functions_3d.glsl,
+// which only declare the version and the view uniforms. It is written against DIMENSION and vecN, which
+// ParticleLeniaCore::glsl_prefix defines after the version line, and mirrors the cpu kernels of ParticleLeniaCore.
+
+#ifdef SPECIALIZED
+// the parameters are compiled in as constants (see shader_variants.hpp), so the driver can fold them into the
+// functions below, only num_particles still changes at runtime and is read from the block, whose layout stays the same
+layout (std140) uniform LeniaParams {
+    // w_k, mu_k, sigma_k2, mu_g, sigma_g2, c_rep, r_distance
+    float baked_0, baked_1, baked_2, baked_3, baked_4, baked_5, baked_6;
+    int num_particles;
+};
+
+const float w_k = SPECIALIZED_W_K;
+const float mu_k = SPECIALIZED_MU_K;
+const float sigma_k2 = SPECIALIZED_SIGMA_K2;
+const float mu_g = SPECIALIZED_MU_G;
+const float sigma_g2 = SPECIALIZED_SIGMA_G2;
+const float c_rep = SPECIALIZED_C_REP;
+const float r_distance = SPECIALIZED_R_DISTANCE;
+const float h = SPECIALIZED_H;
+const float h2 = SPECIALIZED_H2;
+const float dt = SPECIALIZED_DT;
+const bool analytic_gradient = SPECIALIZED_ANALYTIC_GRADIENT;
+#else
+// simulation parameters, one uniform buffer shared by all shaders, mirrored by LeniaParams in lenia_params.hpp
+layout (std140) uniform LeniaParams {
+    // parameters for the kernel
+    float w_k;
+    float mu_k;
+    // sigma k squared
+    float sigma_k2;
+
+    // parameters for the growth field
+    float mu_g;
+    // sigma g squared
+    float sigma_g2;
+
+    // factor used to scale repulsion
+    float c_rep;
+    // minimum distance to particle for repulsion
+    float r_distance;
+
+    // number of particles
+    int num_particles;
+
+    // value for gradient calculations
+    float h;
+    float h2;
+    // time step size
+    float dt;
+    // evaluate the energy gradient analytically in one pass instead of using central differences (uses h)
+    bool analytic_gradient;
+};
+#endif
+
+// std430 pads the elements of vec3 arrays to 16 bytes, the 3D buffers hold a vec4 per particle (see ParticleLayout)
+layout (std430) restrict buffer ParticlesBuffer {
+    vecN particles[];
+};
+
+// calculates the euclidean norm of a vector
+float euclid_norm(vecN vec) {
+    float sum = 0.0;
+    for (int d = 0; d < DIMENSION; ++d) sum += vec[d] * vec[d];
+    return sqrt(sum);
+}
+
+// applies the kernel function to a value r
+float K(float r) {
+    return w_k *
+    exp(
+        -pow(r - mu_k, 2.0) / sigma_k2
+    );
+}
+
+// derivative of the kernel function K with respect to r
+// K'(r) = -2 * (r - mu_k) / sigma_k^2 * K(r)
+float K_derivative(float r) {
+    return -2.0 * (r - mu_k) / sigma_k2 * K(r);
+}
+
+// adds the contribution of a particle at distance norm to the fields U and R
+void add_U_and_R(float norm, inout float u, inout float r) {
+    u += K(norm);
+    if (norm >= r_distance) {
+        r += pow(max(1.0 - norm, 0.0), 2.0);
+    }
+}
+
+// calculates the value of the field U and the repulsion field R at the given position using the following formula
+// U(position) = sum_(i=0)^(num_particles-1) K(||position - particle_i||
+// R(position) = (c_rep / 2) * sum_(i in particles that aren't directly at position) max(1 - ||x - particle||, 0)^2
+// with use_grid only particles within grid_cutoff are summed up
+vec2 U_and_R(vecN position) {
+    float u = 0.0;
+    float r = 0.0;
+    if (use_grid) {
+        uint cells[NEIGHBOUR_CELLS];
+        int num_cells = neighbour_cells(position, cells);
+        for (int c = 0; c < num_cells; ++c) {
+            uint end = cell_start[cells[c]] + cell_count[cells[c]];
+            for (uint i = cell_start[cells[c]]; i < end; ++i) {
+                float norm = euclid_norm(sorted_particles[i] - position);
+                // skips particles of far away cells that share the slot in the hash table
+                if (norm <= grid_cutoff) add_U_and_R(norm, u, r);
+            }
+        }
+    } else {
+        for (int i = 0; i < num_particles; ++i) {
+            add_U_and_R(euclid_norm(particles[i] - position), u, r);
+        }
+    }
+    return vec2(u, r);
+}
+
+// calculates the value of the growth field G based on the field U using the following formula
+// G(u) = exp(-(u - mu_G)^2 / sigma_G^2)
+float G(float u) {
+    return exp(
+        -pow(u - mu_g, 2.0) / sigma_g2
+    );
+}
+
+// derivative of the growth field G with respect to u
+// G'(u) = -2 * (u - mu_G) / sigma_G^2 * G(u)
+float G_derivative(float u) {
+    return -2.0 * (u - mu_g) / sigma_g2 * G(u);
+}
+
+// calculates the value of the energy field based on the value of the repulsion and the growth field
+float E(float r, float g) {
+    return r - g;
+}
+
+// calculates the values of all fields and returns a vec4
+// with the values in the following ortder: u, r, g, e
+vec4 fields(vecN position) {
+    vec2 ur = U_and_R(position);
+    float g = G(ur.x);
+    float e = E(ur.y, g);
+    return vec4(ur.x, ur.y, g, e);
+}
\ No newline at end of file
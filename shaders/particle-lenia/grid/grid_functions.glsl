@@ -0,0 +1,69 @@
+// FILE: shaders/particle-lenia/grid/grid_functions.glsl
+// this file get's inserted after the version line of every shader that uses the particle grid,
+// DIMENSION, vecN and ivecN have to be defined before it (see ParticleLeniaCore::glsl_prefix)
+
+#if DIMENSION == 3
+#define NEIGHBOUR_CELLS 27
+#else
+#define NEIGHBOUR_CELLS 9
+#endif
+
+// evaluate fields only over the particles in the cells around a position instead of all particles
+uniform bool use_grid = false;
+// edge length of a grid cell, at least grid_cutoff
+uniform float grid_cell_size = 1.0;
+// particles that are further away are ignored when the grid is used
+uniform float grid_cutoff = 1.0;
+// number of slots in the hash table of cells, a power of two
+uniform int grid_cells = 1;
+
+// particles of slot c are sorted_particles[cell_start[c]] to sorted_particles[cell_start[c] + cell_count[c] - 1]
+layout (std430) restrict readonly buffer GridCellStart {
+    uint cell_start[];
+};
+
+layout (std430) restrict readonly buffer GridCellCount {
+    uint cell_count[];
+};
+
+layout (std430) restrict readonly buffer SortedParticlesBuffer {
+    vecN sorted_particles[];
+};
+
+// returns the integer coordinates of the cell that contains position
+ivecN cell_of(vecN position) {
+    return ivecN(floor(position / grid_cell_size));
+}
+
+// maps the (unbounded) cell coordinates to a slot in the hash table
+uint cell_hash(ivecN cell) {
+#if DIMENSION == 3
+    uint hash = (uint(cell.x) * 73856093u) ^ (uint(cell.y) * 19349663u) ^ (uint(cell.z) * 83492791u);
+#else
+    uint hash = (uint(cell.x) * 73856093u) ^ (uint(cell.y) * 19349663u);
+#endif
+    return hash & uint(grid_cells - 1);
+}
+
+// writes the slots of the 3^DIMENSION cells around the cell of position into cells and returns their number,
+// neighbouring cells that collide in the hash table are only written once, so no particle is visited twice
+int neighbour_cells(vecN position, out uint cells[NEIGHBOUR_CELLS]) {
+    ivecN center = cell_of(position);
+    int count = 0;
+#if DIMENSION == 3
+    for (int dz = -1; dz <= 1; ++dz)
+#endif
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+#if DIMENSION == 3
+            uint cell = cell_hash(center + ivec3(dx, dy, dz));
+#else
+            uint cell = cell_hash(center + ivec2(dx, dy));
+#endif
+            bool visited = false;
+            for (int i = 0; i < count; ++i) visited = visited || cells[i] == cell;
+            if (!visited) cells[count++] = cell;
+        }
+    }
+    return count;
+}
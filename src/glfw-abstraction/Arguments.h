@@ -1,6 +1,7 @@
 #ifndef SLIME_SIMULATION_ARGUMENTS_H
 #define SLIME_SIMULATION_ARGUMENTS_H
 
+#include <cstdio>
 #include <string>
 
 template<typename T>
@@ -24,6 +25,32 @@ std::string generate_arguments(Argument<std::string> arg) {
     return "#define " + arg.name + " " + arg.value + "\n";
 }
 
+// floats are written with 9 significant digits, which reads back as the exact same float (std::to_string only writes
+// 6 decimals, so 1e-10 would become 0.000000), and always as a float literal, so glsl doesn't see an int
+inline std::string generate_arguments(Argument<float> arg) {
+    char value[32];
+    std::snprintf(value, sizeof(value), "%.9g", arg.value);
+    std::string literal = value;
+    if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+    return "#define " + arg.name + " " + literal + "\n";
+}
+
+// glsl has no implicit conversion from int to bool
+inline std::string generate_arguments(Argument<bool> arg) {
+    return "#define " + arg.name + " " + (arg.value ? "true" : "false") + "\n";
+}
+
+/**
+ * Returns the position directly after the #version line of a shader, this is where arguments get inserted.
+ * Falls back to the end of the first line for shaders without a version line.
+ */
+inline std::string::size_type after_version_line(const std::string &code) {
+    std::string::size_type version = code.find("#version");
+    if (version == std::string::npos) version = 0;
+    std::string::size_type end_of_line = code.find('\n', version);
+    return end_of_line == std::string::npos ? code.length() : end_of_line + 1;
+}
+
 template<typename... Arguments>
 std::string generate_arguments_with_default_marker(Arguments... arguments) {
     return "#define default_consts\n" + generate_arguments(arguments...);
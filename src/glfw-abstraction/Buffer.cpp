@@ -1,40 +1,146 @@
+#include <algorithm>
 #include <cstring>
 #include "Buffer.h"
+#include "GlObjects.h"
 
-Buffer::Buffer() {}
+// shaders write the particles and the cpu reads them back, so persistent buffers are mapped for both
+static const GLbitfield PERSISTENT_ACCESS = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                            GL_MAP_COHERENT_BIT;
 
-Buffer::Buffer(int size, int type) : size(size), type(type) {}
+Buffer::Buffer() : id(0), size(0), type(GL_SHADER_STORAGE_BUFFER), persistent(false), mapped(nullptr) {}
+
+Buffer::Buffer(int size, int type, bool persistent) : id(0), size(size), type(type), persistent(persistent),
+                                                      mapped(nullptr) {}
+
+Buffer::Buffer(Buffer &&other) noexcept: id(std::exchange(other.id, 0)), size(other.size), type(other.type),
+                                         persistent(other.persistent),
+                                         mapped(std::exchange(other.mapped, nullptr)) {}
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept {
+    if (this != &other) {
+        delete_buffer();
+        id = std::exchange(other.id, 0);
+        size = other.size;
+        type = other.type;
+        persistent = other.persistent;
+        mapped = std::exchange(other.mapped, nullptr);
+    }
+    return *this;
+}
+
+Buffer::~Buffer() {
+    delete_buffer();
+}
 
 void Buffer::init() {
+    // calling init again replaces the buffer
+    delete_buffer();
     glGenBuffers(1, &id);
+    GL_OBJECTS.buffers.add((long long) sizeof(float) * size);
     glBindBuffer(type, id);
-    glBufferData(type, sizeof(float) * size, nullptr, GL_DYNAMIC_DRAW);
+    // immutable storage can't be empty
+    if (persistent && size > 0) {
+        // GL_DYNAMIC_STORAGE_BIT keeps glBufferSubData and glClearBufferData working on the immutable storage
+        glBufferStorage(type, sizeof(float) * size, nullptr, PERSISTENT_ACCESS | GL_DYNAMIC_STORAGE_BIT);
+        mapped = (float *) glMapBufferRange(type, 0, sizeof(float) * size, PERSISTENT_ACCESS);
+    } else {
+        glBufferData(type, sizeof(float) * size, nullptr, GL_DYNAMIC_DRAW);
+    }
     glBindBuffer(type, 0);
 }
 
 void Buffer::set_data(const std::vector<float> &data) {
+    size_t count = std::min(data.size(), (size_t) size);
+    if (mapped) {
+        sync();
+        memcpy(mapped, data.data(), sizeof(float) * count);
+        return;
+    }
     glBindBuffer(type, id);
     GLvoid* p = glMapBuffer(type, GL_WRITE_ONLY);
-    memcpy(p, data.data(), sizeof(float) * size);
+    memcpy(p, data.data(), sizeof(float) * count);
     glUnmapBuffer(type);
 }
 
+void Buffer::set_sub_data(int offset, const float *data, int count) const {
+    glBindBuffer(type, id);
+    glBufferSubData(type, sizeof(float) * offset, sizeof(float) * count, data);
+}
+
+void Buffer::set_data(const void *data, GLsizeiptr bytes) const {
+    if (mapped) {
+        sync();
+        memcpy(mapped, data, bytes);
+        return;
+    }
+    glBindBuffer(type, id);
+    glBufferSubData(type, 0, bytes, data);
+}
+
 std::vector<float> Buffer::get_data() const {
     std::vector<float> data(size);
+    get_data(data);
+    return data;
+}
+
+void Buffer::get_data(std::vector<float> &data) const {
+    data.resize(size);
+    if (mapped) {
+        sync();
+        memcpy(data.data(), mapped, sizeof(float) * size);
+        return;
+    }
     glBindBuffer(type, id);
     glGetBufferSubData(type, 0, size * sizeof(float), data.data());
-    glUnmapBuffer(type);
-    return data;
 }
 
-void Buffer::bind(int index) const {
-    glBindBufferBase(type, index, id);
+float *Buffer::mapped_data() const {
+    return mapped;
 }
 
-void Buffer::delete_buffer() {
-    glDeleteBuffers(1, &id);
-    id = -1;
+void Buffer::sync() const {
+    // shader writes only reach persistent mappings after this barrier, the mapping is coherent otherwise, so once
+    // the commands that use the buffer finished their writes are visible and overwriting can't change what they read
+    glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(fence);
+}
+
+void Buffer::grow(int new_size) {
+    if (new_size <= size) return;
+    Buffer grown(new_size, type, persistent);
+    grown.init();
+    if (size > 0) {
+        // the old values have usually just been written by a shader
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown.id);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(float) * size);
+    }
+    // the driver keeps the old storage alive until the copy is done
+    *this = std::move(grown);
 }
 
+void Buffer::bind(int index) const {
+    glBindBufferBase(type, index, id);
+}
 
+void Buffer::clear() const {
+    glBindBuffer(type, id);
+    glClearBufferData(type, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+}
 
+void Buffer::delete_buffer() {
+    if (id == 0) return;
+    GL_OBJECTS.buffers.remove((long long) sizeof(float) * size);
+    if (!GL_CONTEXT_DESTROYED) {
+        if (mapped) {
+            glBindBuffer(type, id);
+            glUnmapBuffer(type);
+        }
+        glDeleteBuffers(1, &id);
+    }
+    mapped = nullptr;
+    id = 0;
+}
@@ -3,24 +3,81 @@
 
 #include <vector>
 #include <glad/glad.h>
+#include <utility>
 
+/**
+ * Owns a gl buffer object, which is deleted with it. Buffers can be moved but not copied, so the object always has
+ * exactly one owner.
+ */
 class Buffer {
 public:
     Buffer();
-    explicit Buffer(int size, int type);
+
+    /**
+     * @param size number of floats
+     * @param persistent allocate immutable storage that stays mapped (coherently) for the lifetime of the buffer,
+     * set_data and get_data then copy through mapped_data() instead of mapping or allocating on every call
+     */
+    explicit Buffer(int size, int type, bool persistent = false);
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    Buffer(Buffer &&other) noexcept;
+
+    // deletes the buffer this one owned before
+    Buffer &operator=(Buffer &&other) noexcept;
+
+    ~Buffer();
 
     void init();
 
+    // copies data to the start of the buffer, at most size values
     void set_data(const std::vector<float> &data);
+
+    /**
+     * Copies count values to the buffer starting at value offset. Goes through glBufferSubData, so it is ordered with
+     * the commands before and after and doesn't wait for the gpu, even for persistent buffers.
+     */
+    void set_sub_data(int offset, const float *data, int count) const;
+
+    // copies bytes of raw data to the start of the buffer, for buffers that don't hold floats (e.g. uniform blocks)
+    void set_data(const void *data, GLsizeiptr bytes) const;
     std::vector<float> get_data() const;
 
+    // copies the buffer into data, which is only reallocated if it is too small
+    void get_data(std::vector<float> &data) const;
+
+    /**
+     * Pointer to the mapped storage of a persistent buffer, nullptr otherwise.
+     * Only access it after sync(), the gpu may still read or write the buffer before.
+     */
+    float *mapped_data() const;
+
+    // places a fence after all commands issued so far (and their shader writes) and blocks until the gpu passed it
+    void sync() const;
+
+    /**
+     * Reallocates the buffer with room for new_size values and copies the old values over on the gpu
+     * (glCopyBufferSubData). The id changes, so the buffer has to be bound again. Does nothing if it is large enough.
+     */
+    void grow(int new_size);
+
     void bind(int index) const;
 
+    // sets every value of the buffer to zero on the gpu
+    void clear() const;
+
+    // deletes the gl object now instead of with the Buffer, can be called more than once
     void delete_buffer();
 
     GLuint id;
     int size;
     int type;
+    bool persistent;
+
+private:
+    float *mapped;
 };
 
 
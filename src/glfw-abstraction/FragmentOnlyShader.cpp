@@ -2,13 +2,50 @@
 
 #include <glad/glad.h>
 #include "Init.h"
+#include "GlObjects.h"
 
 FragmentOnlyShader::FragmentOnlyShader(const char *fragmentPath) : SimpleShader("shaders/passthrough/shader.vert",
                                                                                 fragmentPath),
                                                                    VBO(0), VAO(0), EBO(0), framebuffer(0) {}
 
-void FragmentOnlyShader::init(const std::string &arguments) {
-    SimpleShader::init(arguments);
+FragmentOnlyShader::FragmentOnlyShader(FragmentOnlyShader &&other) noexcept: SimpleShader(std::move(other)),
+                                                                             VBO(std::exchange(other.VBO, 0)),
+                                                                             VAO(std::exchange(other.VAO, 0)),
+                                                                             EBO(std::exchange(other.EBO, 0)),
+                                                                             framebuffer(
+                                                                                     std::exchange(other.framebuffer,
+                                                                                                   0)) {}
+
+FragmentOnlyShader &FragmentOnlyShader::operator=(FragmentOnlyShader &&other) noexcept {
+    if (this != &other) {
+        delete_objects();
+        SimpleShader::operator=(std::move(other));
+        VBO = std::exchange(other.VBO, 0);
+        VAO = std::exchange(other.VAO, 0);
+        EBO = std::exchange(other.EBO, 0);
+        framebuffer = std::exchange(other.framebuffer, 0);
+    }
+    return *this;
+}
+
+FragmentOnlyShader::~FragmentOnlyShader() {
+    delete_objects();
+}
+
+void FragmentOnlyShader::delete_objects() {
+    if (VAO == 0) return;
+    if (!GL_CONTEXT_DESTROYED) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    VBO = VAO = EBO = framebuffer = 0;
+}
+
+void FragmentOnlyShader::finish_init() {
+    SimpleShader::finish_init();
+    delete_objects();
 
 
     // setup vertices
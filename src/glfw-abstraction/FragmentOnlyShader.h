@@ -11,7 +11,15 @@ public:
 
     explicit FragmentOnlyShader(const char *fragmentPath);
 
-    void init(const std::string &arguments) override;
+    FragmentOnlyShader(FragmentOnlyShader &&other) noexcept;
+
+    FragmentOnlyShader &operator=(FragmentOnlyShader &&other) noexcept;
+
+    // also deletes the quad and the framebuffer
+    ~FragmentOnlyShader() override;
+
+    // sets up the quad and the framebuffer after the program
+    void finish_init() override;
 
     // calls the shaders and renders to the current framebuffer
     void render() const;
@@ -21,6 +29,10 @@ public:
 
     // calls the shaders and renders the result to the window
     void render_to_window() const;
+
+private:
+    // deletes the quad and the framebuffer
+    void delete_objects();
 };
 
 
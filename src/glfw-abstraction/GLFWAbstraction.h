@@ -9,5 +9,8 @@
 #include "SimpleShader.h"
 #include "Texture.h"
 #include "Buffer.h"
+#include "GlObjects.h"
+#include "ProgramCache.h"
+#include "ReadbackRing.h"
 
 #endif //GAME_OF_LIFE_GLFWABSTRACTION_H
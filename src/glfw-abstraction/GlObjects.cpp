@@ -0,0 +1,18 @@
+#include "GlObjects.h"
+
+#include <cstdio>
+
+GlObjectStatistics GL_OBJECTS;
+bool GL_CONTEXT_DESTROYED = false;
+
+static std::string count_summary(const char *kind, const GlObjectCount &count) {
+    char line[128];
+    std::snprintf(line, sizeof(line), "%s: %ld live (%.1f MB), %ld created\n", kind, count.live,
+                  (double) count.bytes / (1024 * 1024), count.created);
+    return line;
+}
+
+std::string GlObjectStatistics::summary() const {
+    return count_summary("buffers", buffers) + count_summary("textures", textures) +
+           count_summary("programs", programs);
+}
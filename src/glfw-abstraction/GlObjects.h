@@ -0,0 +1,43 @@
+#ifndef GAME_OF_LIFE_GLOBJECTS_H
+#define GAME_OF_LIFE_GLOBJECTS_H
+
+#include <string>
+
+// gl objects of one kind: how many are alive, how much memory they hold and how many were created in total
+struct GlObjectCount {
+    long live = 0;
+    long long bytes = 0;
+    long created = 0;
+
+    void add(long long object_bytes) {
+        ++live;
+        ++created;
+        bytes += object_bytes;
+    }
+
+    void remove(long long object_bytes) {
+        --live;
+        bytes -= object_bytes;
+    }
+};
+
+/**
+ * Counts the objects owned by Buffer, Texture and the shaders. Live objects that keep growing point to a leak,
+ * created growing much faster than live to reallocation churn.
+ */
+struct GlObjectStatistics {
+    GlObjectCount buffers;
+    GlObjectCount textures;
+    GlObjectCount programs;
+
+    // one line per kind, e.g. "buffers: 12 live (3.2 MB), 40 created"
+    std::string summary() const;
+};
+
+extern GlObjectStatistics GL_OBJECTS;
+
+// set by init() once the window and its context have been destroyed, objects destroyed afterwards (e.g. globals)
+// don't call into OpenGL anymore, their objects were freed with the context
+extern bool GL_CONTEXT_DESTROYED;
+
+#endif //GAME_OF_LIFE_GLOBJECTS_H
@@ -6,6 +6,8 @@
 
 #include <iostream>
 
+#include "GlObjects.h"
+
 extern int CURRENT_WIDTH, CURRENT_HEIGHT;
 
 static void framebuffer_size_callback(GLFWwindow *window, int width, int height);
@@ -65,6 +67,8 @@ void init(int width, int height, std::string title) {
     }
 
     glfwTerminate();
+    // objects that outlive the window (globals) must not call into OpenGL anymore
+    GL_CONTEXT_DESTROYED = true;
 }
 
 // checks if the ESC-key is pressed and closes the window if it is
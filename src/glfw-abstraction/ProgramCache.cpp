@@ -0,0 +1,141 @@
+#include "ProgramCache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+std::string PROGRAM_CACHE_DIRECTORY = "shader_cache";
+ProgramCacheStatistics PROGRAM_CACHE;
+
+// GL_COMPLETION_STATUS_KHR of GL_KHR_parallel_shader_compile, glad is generated without extensions
+static const GLenum COMPLETION_STATUS = 0x91B1;
+
+// first line of every cached binary, followed by the binary format on the second line
+static const char *const PROGRAM_BINARY_MAGIC = "particle lenia program binary";
+
+std::string ProgramCacheStatistics::summary() const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "shaders: %d from cache, %d compiled (%d rejected binaries) in %.1f ms",
+                  loaded, compiled, rejected, seconds * 1000);
+    return line;
+}
+
+static std::string gl_string(GLenum name) {
+    const char *value = (const char *) glGetString(name);
+    return value ? value : "";
+}
+
+// 64 bit FNV-1a, only has to tell programs apart, not resist attacks
+static void hash_bytes(uint64_t &hash, const std::string &bytes) {
+    for (unsigned char c: bytes) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    // separator, so ("ab", "c") and ("a", "bc") differ
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+}
+
+static std::string binary_path(const std::string &key) {
+    return PROGRAM_CACHE_DIRECTORY + "/" + key + ".bin";
+}
+
+static bool binaries_supported() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return !PROGRAM_CACHE_DIRECTORY.empty() && formats > 0;
+}
+
+std::string program_cache_key(const std::vector<std::string> &sources) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash_bytes(hash, gl_string(GL_VENDOR));
+    hash_bytes(hash, gl_string(GL_RENDERER));
+    hash_bytes(hash, gl_string(GL_VERSION));
+    for (const std::string &source: sources) hash_bytes(hash, source);
+
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash);
+    return key;
+}
+
+GLuint load_program_binary(const std::string &key) {
+    if (!binaries_supported()) return 0;
+    std::ifstream file(binary_path(key), std::ios::binary);
+    if (!file) return 0;
+
+    std::string magic;
+    GLenum format;
+    std::getline(file, magic);
+    if (magic != PROGRAM_BINARY_MAGIC || !(file >> format) || file.get() != '\n') {
+        ++PROGRAM_CACHE.rejected;
+        return 0;
+    }
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), (GLsizei) binary.size());
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // the binary is overwritten once the program has been compiled again
+        glDeleteProgram(program);
+        ++PROGRAM_CACHE.rejected;
+        return 0;
+    }
+    ++PROGRAM_CACHE.loaded;
+    return program;
+}
+
+void store_program_binary(const std::string &key, GLuint program) {
+    ++PROGRAM_CACHE.compiled;
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success || !binaries_supported()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+#ifdef _WIN32
+    _mkdir(PROGRAM_CACHE_DIRECTORY.c_str());
+#else
+    mkdir(PROGRAM_CACHE_DIRECTORY.c_str(), 0755);
+#endif
+    std::ofstream file(binary_path(key), std::ios::binary);
+    file << PROGRAM_BINARY_MAGIC << '\n' << format << '\n';
+    file.write(binary.data(), (std::streamsize) binary.size());
+    if (!file) std::cerr << "failed to write the program binary " << binary_path(key) << std::endl;
+}
+
+bool parallel_shader_compile_supported() {
+    static int supported = -1;
+    if (supported < 0) {
+        GLint extensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        supported = 0;
+        for (GLint i = 0; i < extensions; ++i) {
+            std::string extension = (const char *) glGetStringi(GL_EXTENSIONS, i);
+            if (extension == "GL_KHR_parallel_shader_compile" || extension == "GL_ARB_parallel_shader_compile") {
+                supported = 1;
+            }
+        }
+    }
+    return supported == 1;
+}
+
+bool program_link_completed(GLuint program) {
+    if (!parallel_shader_compile_supported()) return true;
+    GLint completed = GL_TRUE;
+    glGetProgramiv(program, COMPLETION_STATUS, &completed);
+    return completed == GL_TRUE;
+}
@@ -0,0 +1,67 @@
+#ifndef GAME_OF_LIFE_PROGRAMCACHE_H
+#define GAME_OF_LIFE_PROGRAMCACHE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+/**
+ * On-disk cache of linked programs (glGetProgramBinary / glProgramBinary), so shaders are only compiled the first
+ * time a program is built on a device. Programs are keyed by a hash of their final source code (which includes the
+ * arguments put after the version line) and of GL_VENDOR, GL_RENDERER and GL_VERSION, so a driver update starts over.
+ */
+
+// directory of the cached binaries, relative to the working directory like the shaders, empty disables the cache
+extern std::string PROGRAM_CACHE_DIRECTORY;
+
+struct ProgramCacheStatistics {
+    // programs created from a cached binary
+    int loaded = 0;
+    // programs compiled from source, their binaries are stored afterwards
+    int compiled = 0;
+    // cached binaries the driver didn't accept (e.g. after an update that kept the version string), compiled instead
+    int rejected = 0;
+    // time spent in init() of all shaders
+    double seconds = 0;
+
+    // e.g. "shaders: 3 from cache, 1 compiled (0 rejected binaries) in 12.3 ms"
+    std::string summary() const;
+};
+
+extern ProgramCacheStatistics PROGRAM_CACHE;
+
+// key of a program built from the given sources on the current device, needs a current OpenGL context
+std::string program_cache_key(const std::vector<std::string> &sources);
+
+/**
+ * Creates a program from the cached binary of a key.
+ * @return the linked program, 0 if there is no binary or the driver rejected it
+ */
+GLuint load_program_binary(const std::string &key);
+
+/**
+ * Stores the binary of a linked program, which has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+ * Programs that failed to link aren't stored.
+ */
+void store_program_binary(const std::string &key, GLuint program);
+
+// whether the driver compiles and links on its own threads (GL_KHR_parallel_shader_compile or the ARB version)
+bool parallel_shader_compile_supported();
+
+/**
+ * Whether glLinkProgram finished, so querying the program doesn't block. Always true without parallel shader
+ * compilation, the driver then does the work when the program is first queried.
+ */
+bool program_link_completed(GLuint program);
+
+// adds the time from its construction to its destruction to PROGRAM_CACHE.seconds
+struct ProgramInitTimer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    ~ProgramInitTimer() {
+        PROGRAM_CACHE.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif //GAME_OF_LIFE_PROGRAMCACHE_H
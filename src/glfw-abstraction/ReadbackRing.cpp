@@ -0,0 +1,138 @@
+#include "ReadbackRing.h"
+#include "GlObjects.h"
+
+ReadbackRing::ReadbackRing(int slots) : slots(slots > 0 ? slots : 1) {}
+
+ReadbackRing::ReadbackRing(ReadbackRing &&other) noexcept: stalls(other.stalls), slots(std::move(other.slots)),
+                                                            oldest(std::exchange(other.oldest, 0)),
+                                                            pending_slots(std::exchange(other.pending_slots, 0)),
+                                                            pending_copies(std::exchange(other.pending_copies, 0)),
+                                                            batch(std::exchange(other.batch, -1)),
+                                                            batch_copies(other.batch_copies),
+                                                            batch_size(other.batch_size) {}
+
+ReadbackRing &ReadbackRing::operator=(ReadbackRing &&other) noexcept {
+    if (this != &other) {
+        delete_buffers();
+        stalls = other.stalls;
+        slots = std::move(other.slots);
+        oldest = std::exchange(other.oldest, 0);
+        pending_slots = std::exchange(other.pending_slots, 0);
+        pending_copies = std::exchange(other.pending_copies, 0);
+        batch = std::exchange(other.batch, -1);
+        batch_copies = other.batch_copies;
+        batch_size = other.batch_size;
+    }
+    return *this;
+}
+
+ReadbackRing::~ReadbackRing() {
+    delete_buffers();
+}
+
+void ReadbackRing::request(const Buffer &source, Callback callback, int size) {
+    if (size < 0 || size > source.size) size = source.size;
+    if (batch >= 0 && batch_copies > 0 && size <= batch_size) {
+        Slot &slot = slots[batch];
+        int offset = (int) slot.copies.size() * batch_size;
+        copy(source, slot, offset, size);
+        slot.copies.push_back(Copy{std::move(callback), offset, size});
+        --batch_copies;
+        ++pending_copies;
+        return;
+    }
+
+    Slot &slot = acquire_slot(size);
+    copy(source, slot, 0, size);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.copies.push_back(Copy{std::move(callback), 0, size});
+    ++pending_copies;
+}
+
+void ReadbackRing::begin_batch(int copies, int size) {
+    end_batch();
+    if (copies <= 0 || size <= 0) return;
+    Slot &slot = acquire_slot(copies * size);
+    batch = (int) (&slot - slots.data());
+    batch_copies = copies;
+    batch_size = size;
+}
+
+void ReadbackRing::end_batch() {
+    if (batch < 0) return;
+    // also fenced if nothing was requested, later slots may already be in use
+    slots[batch].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    batch = -1;
+}
+
+void ReadbackRing::poll() {
+    while (pending_slots > 0 && deliver_oldest(false)) {}
+}
+
+void ReadbackRing::finish() {
+    end_batch();
+    while (pending_slots > 0) deliver_oldest(true);
+}
+
+int ReadbackRing::pending() const {
+    return pending_copies;
+}
+
+void ReadbackRing::delete_buffers() {
+    for (Slot &slot: slots) {
+        if (slot.fence && !GL_CONTEXT_DESTROYED) glDeleteSync(slot.fence);
+        slot = Slot();
+    }
+    oldest = 0;
+    pending_slots = 0;
+    pending_copies = 0;
+    batch = -1;
+}
+
+ReadbackRing::Slot &ReadbackRing::acquire_slot(int size) {
+    if (pending_slots == (int) slots.size()) {
+        ++stalls;
+        deliver_oldest(true);
+    }
+
+    Slot &slot = slots[(oldest + pending_slots) % slots.size()];
+    // staging buffers are (re)allocated lazily, so the ring adapts to the size of the buffers it reads
+    if (slot.staging.size < size) {
+        slot.staging = Buffer(size, GL_COPY_WRITE_BUFFER, true);
+        slot.staging.init();
+    }
+    ++pending_slots;
+    return slot;
+}
+
+void ReadbackRing::copy(const Buffer &source, Slot &slot, int offset, int size) {
+    // the source has usually just been written by a shader
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, source.id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, slot.staging.id);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, sizeof(float) * offset, sizeof(float) * size);
+}
+
+bool ReadbackRing::deliver_oldest(bool wait) {
+    Slot &slot = slots[oldest];
+    // the open batch has no fence yet, it can only be delivered after end_batch()
+    if (slot.fence == nullptr) return false;
+    // the flush makes sure the copy is submitted, otherwise the fence might never be reached
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+    if (status == GL_TIMEOUT_EXPIRED) return false;
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    // the staging buffer is mapped coherently, the copies are visible once their fence has passed
+    for (Copy &copy: slot.copies) {
+        copy.callback(slot.staging.mapped_data() + copy.offset, copy.size);
+        --pending_copies;
+    }
+    slot.copies.clear();
+    oldest = (oldest + 1) % (int) slots.size();
+    --pending_slots;
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef GAME_OF_LIFE_READBACKRING_H
+#define GAME_OF_LIFE_READBACKRING_H
+
+#include <functional>
+#include <vector>
+#include <glad/glad.h>
+#include <utility>
+
+#include "Buffer.h"
+
+/**
+ * Reads buffers back to the cpu without stalling the pipeline.
+ * Every request copies the buffer on the gpu into the next of a ring of persistently mapped staging buffers
+ * (glCopyBufferSubData) and places a fence behind the copy. poll() hands the copies whose fence has passed to their
+ * callbacks, in the order they were requested, usually a frame or two later.
+ * Requests between begin_batch() and end_batch() go into one staging buffer behind one fence, so a batch takes a
+ * single slot however many copies it holds.
+ */
+class ReadbackRing {
+public:
+    // data points to size floats, it is only valid during the call
+    typedef std::function<void(const float *data, int size)> Callback;
+
+    // number of requests that found every staging buffer in use and had to wait for the oldest copy
+    long stalls = 0;
+
+    /**
+     * @param slots number of staging buffers, i.e. how many copies may be in flight at once
+     */
+    explicit ReadbackRing(int slots = 4);
+
+    ReadbackRing(ReadbackRing &&other) noexcept;
+
+    // drops the copies pending in this ring
+    ReadbackRing &operator=(ReadbackRing &&other) noexcept;
+
+    ~ReadbackRing();
+
+    /**
+     * Copies the current content of a buffer into a staging buffer, MUST be called after glfw has been initialized.
+     * Only blocks if all staging buffers are in use, then the oldest copy is delivered first.
+     * @param callback called with the copy by poll() or finish()
+     * @param size number of values to copy from the start of the buffer, the whole buffer if negative
+     */
+    void request(const Buffer &source, Callback callback, int size = -1);
+
+    /**
+     * Collects the following requests in one staging buffer until end_batch(), only blocks if all staging buffers are
+     * in use. Requests beyond copies or larger than size are copied on their own.
+     * @param copies maximum number of requests in the batch
+     * @param size maximum number of values per request
+     */
+    void begin_batch(int copies, int size);
+
+    // places the fence behind the copies of the batch, they are delivered together
+    void end_batch();
+
+    // delivers all copies that are finished, never blocks
+    void poll();
+
+    // blocks until every requested copy has been delivered
+    void finish();
+
+    // number of requested copies that haven't been delivered yet
+    int pending() const;
+
+    // frees the staging buffers and the fences, pending copies are dropped
+    void delete_buffers();
+
+private:
+    // one request, the values are at offset in the staging buffer of its slot
+    struct Copy {
+        Callback callback;
+        int offset;
+        int size;
+    };
+
+    struct Slot {
+        Buffer staging;
+        GLsync fence = nullptr;
+        std::vector<Copy> copies;
+    };
+
+    std::vector<Slot> slots;
+    // slot of the oldest pending copy
+    int oldest = 0;
+    // number of slots in use, including the batch that is being collected
+    int pending_slots = 0;
+    int pending_copies = 0;
+    // slot of the open batch, -1 outside of begin_batch() and end_batch(), and the room left in it
+    int batch = -1;
+    int batch_copies = 0;
+    int batch_size = 0;
+
+    // makes the next slot pending and its staging buffer at least size values large, delivers the oldest copy first
+    // if every slot is in use
+    Slot &acquire_slot(int size);
+
+    // copies size values of source to offset in the staging buffer of slot
+    static void copy(const Buffer &source, Slot &slot, int offset, int size);
+
+    // hands the copies of the oldest slot to their callbacks, waits for them if wait is true
+    bool deliver_oldest(bool wait);
+};
+
+
+#endif //GAME_OF_LIFE_READBACKRING_H
@@ -0,0 +1,80 @@
+#include "ShaderReflection.h"
+
+#include <vector>
+
+// returns the names of all active resources of one interface of the program
+static std::vector<std::string> resource_names(GLuint program, GLenum interface) {
+    GLint count = 0, max_length = 0;
+    glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(program, interface, GL_MAX_NAME_LENGTH, &max_length);
+
+    std::vector<std::string> names;
+    std::vector<char> name(max_length + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        glGetProgramResourceName(program, interface, i, (GLsizei) name.size(), &length, name.data());
+        names.emplace_back(name.data(), length);
+    }
+    return names;
+}
+
+void ShaderReflection::reflect(GLuint program) {
+    uniforms.clear();
+    storage_blocks.clear();
+    storage_block_strides.clear();
+    uniform_blocks.clear();
+
+    const GLenum location_property = GL_LOCATION;
+    std::vector<std::string> names = resource_names(program, GL_UNIFORM);
+    for (GLint i = 0; i < (GLint) names.size(); ++i) {
+        GLint location = -1;
+        glGetProgramResourceiv(program, GL_UNIFORM, i, 1, &location_property, 1, nullptr, &location);
+        // members of uniform blocks have no location, they are set through the buffer
+        if (location < 0) continue;
+        uniforms[names[i]] = location;
+        // arrays are reported as "name[0]", but can be bound by their plain name as well
+        std::string::size_type length = names[i].size();
+        if (length > 3 && names[i].compare(length - 3, 3, "[0]") == 0) {
+            uniforms[names[i].substr(0, length - 3)] = location;
+        }
+    }
+
+    names = resource_names(program, GL_SHADER_STORAGE_BLOCK);
+    const GLenum variables_property = GL_NUM_ACTIVE_VARIABLES, first_variable_property = GL_ACTIVE_VARIABLES;
+    const GLenum stride_property = GL_ARRAY_STRIDE;
+    for (GLint i = 0; i < (GLint) names.size(); ++i) {
+        storage_blocks[names[i]] = i;
+        GLint variables = 0, variable = 0, stride = 0;
+        glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, i, 1, &variables_property, 1, nullptr, &variables);
+        if (variables > 0) {
+            // the active variables are returned in no particular order, so the block is expected to have one
+            glGetProgramResourceiv(program, GL_SHADER_STORAGE_BLOCK, i, 1, &first_variable_property, 1, nullptr,
+                                   &variable);
+            glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, variable, 1, &stride_property, 1, nullptr, &stride);
+        }
+        storage_block_strides[names[i]] = stride;
+    }
+
+    names = resource_names(program, GL_UNIFORM_BLOCK);
+    for (GLint i = 0; i < (GLint) names.size(); ++i) uniform_blocks[names[i]] = i;
+}
+
+GLint ShaderReflection::uniform_location(const std::string &name) const {
+    auto uniform = uniforms.find(name);
+    return uniform == uniforms.end() ? -1 : uniform->second;
+}
+
+GLint ShaderReflection::storage_block_index(const std::string &name) const {
+    auto block = storage_blocks.find(name);
+    return block == storage_blocks.end() ? (GLint) GL_INVALID_INDEX : block->second;
+}
+
+GLint ShaderReflection::storage_block_array_stride(const std::string &name) const {
+    auto stride = storage_block_strides.find(name);
+    return stride == storage_block_strides.end() ? 0 : stride->second;
+}
+
+GLint ShaderReflection::uniform_block_index(const std::string &name) const {
+    auto block = uniform_blocks.find(name);
+    return block == uniform_blocks.end() ? (GLint) GL_INVALID_INDEX : block->second;
+}
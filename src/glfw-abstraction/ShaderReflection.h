@@ -0,0 +1,44 @@
+#ifndef GAME_OF_LIFE_SHADERREFLECTION_H
+#define GAME_OF_LIFE_SHADERREFLECTION_H
+
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+
+/**
+ * Locations of the active uniforms and indices of the active blocks of a linked program.
+ * They are queried once after linking, so binding by name is a hash lookup instead of a
+ * glGetUniformLocation / glGetProgramResourceIndex call.
+ */
+class ShaderReflection {
+public:
+    /**
+     * Queries all active uniforms, shader storage blocks and uniform blocks of the program.
+     * MUST be called after the program has been linked.
+     */
+    void reflect(GLuint program);
+
+    // location of a uniform, -1 if it isn't active (like glGetUniformLocation)
+    GLint uniform_location(const std::string &name) const;
+
+    // index of a shader storage block, GL_INVALID_INDEX if it isn't active
+    GLint storage_block_index(const std::string &name) const;
+
+    /**
+     * Bytes between the elements of the array in a shader storage block (its first member is expected to be one),
+     * like std430 laid it out, e.g. 16 for "vec3 particles[]". 0 if the block isn't active or has no array.
+     */
+    GLint storage_block_array_stride(const std::string &name) const;
+
+    // index of a uniform block, GL_INVALID_INDEX if it isn't active
+    GLint uniform_block_index(const std::string &name) const;
+
+private:
+    std::unordered_map<std::string, GLint> uniforms;
+    std::unordered_map<std::string, GLint> storage_blocks;
+    std::unordered_map<std::string, GLint> storage_block_strides;
+    std::unordered_map<std::string, GLint> uniform_blocks;
+};
+
+
+#endif //GAME_OF_LIFE_SHADERREFLECTION_H
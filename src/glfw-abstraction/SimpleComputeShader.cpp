@@ -1,12 +1,52 @@
 #include "SimpleComputeShader.h"
 
 #include <glad/glad.h>
+#include "Arguments.h"
+#include "GlObjects.h"
+#include "ProgramCache.h"
 
 SimpleComputeShader::SimpleComputeShader() : id(0), path("") {}
 
 SimpleComputeShader::SimpleComputeShader(const char *path) :id(0), path(path) {}
 
+SimpleComputeShader::SimpleComputeShader(SimpleComputeShader &&other) noexcept
+        : id(std::exchange(other.id, 0)), path(other.path), reflection(std::move(other.reflection)),
+          pending_shader(std::exchange(other.pending_shader, 0)), pending_code(std::move(other.pending_code)),
+          pending_key(std::move(other.pending_key)) {}
+
+SimpleComputeShader &SimpleComputeShader::operator=(SimpleComputeShader &&other) noexcept {
+    if (this != &other) {
+        delete_program();
+        id = std::exchange(other.id, 0);
+        path = other.path;
+        reflection = std::move(other.reflection);
+        pending_shader = std::exchange(other.pending_shader, 0);
+        pending_code = std::move(other.pending_code);
+        pending_key = std::move(other.pending_key);
+    }
+    return *this;
+}
+
+SimpleComputeShader::~SimpleComputeShader() {
+    delete_program();
+}
+
+void SimpleComputeShader::delete_program() {
+    if (pending_shader != 0 && !GL_CONTEXT_DESTROYED) glDeleteShader(pending_shader);
+    pending_shader = 0;
+    if (id == 0) return;
+    GL_OBJECTS.programs.remove(0);
+    if (!GL_CONTEXT_DESTROYED) glDeleteProgram(id);
+    id = 0;
+}
+
 void SimpleComputeShader::init(const std::string &arguments) {
+    start_init(arguments);
+    finish_init();
+}
+
+void SimpleComputeShader::start_init(const std::string &arguments) {
+    ProgramInitTimer timer;
     // read shader code from file
     std::string compute_code;
     std::ifstream file;
@@ -21,44 +61,67 @@ void SimpleComputeShader::init(const std::string &arguments) {
 
         compute_code = file_stream.str();
 
-        // insert argument into shader code after version line (=first line)
-        std::string first_line = compute_code.substr(0, compute_code.find('\n') + 1);
-        compute_code.erase(0, compute_code.find('\n') + 1);
-        compute_code = first_line + arguments + compute_code;
+        // insert argument into shader code after the version line
+        // (generated shaders start with comments, so this isn't necessarily the first line)
+        compute_code.insert(after_version_line(compute_code), arguments);
     } catch (const std::ifstream::failure &e) {
         std::cerr << "failed to read ComputeParticle shader file" << std::endl;
     }
 
+    delete_program();
+    pending_key = program_cache_key({compute_code});
+    id = load_program_binary(pending_key);
+    if (id != 0) {
+        GL_OBJECTS.programs.add(0);
+        return;
+    }
+
     const char *c_shader_code = compute_code.c_str();
 
-    // compile shader
-    unsigned int shader = glCreateShader(GL_COMPUTE_SHADER);
-    glShaderSource(shader, 1, &c_shader_code, NULL);
-    glCompileShader(shader);
-
-    // check for compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
-        for (int i = 1; compute_code.length() > 0; ++i) {
-            int position = compute_code.find('\n');
-            std::string line = std::to_string(i) + "\t" + compute_code.substr(0, position);
-            if (position >= 0) compute_code.erase(0, position + 1);
-            else compute_code = "";
-            std::cerr << line << std::endl;
-        }
-    }
+    // compile shader, the status is only checked in finish_init() so the driver doesn't have to finish here
+    pending_shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(pending_shader, 1, &c_shader_code, NULL);
+    glCompileShader(pending_shader);
+    pending_code = std::move(compute_code);
 
     // create program
     id = glCreateProgram();
-    glAttachShader(id, shader);
+    GL_OBJECTS.programs.add(0);
+    glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(id, pending_shader);
     glLinkProgram(id);
+}
 
-    // cleanup
-    glDeleteShader(shader);
+bool SimpleComputeShader::init_ready() const {
+    return program_link_completed(id);
+}
+
+void SimpleComputeShader::finish_init() {
+    ProgramInitTimer timer;
+    if (pending_shader != 0) {
+        // check for compile errors
+        int success;
+        char infoLog[512];
+        glGetShaderiv(pending_shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(pending_shader, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+            for (int i = 1; pending_code.length() > 0; ++i) {
+                int position = pending_code.find('\n');
+                std::string line = std::to_string(i) + "\t" + pending_code.substr(0, position);
+                if (position >= 0) pending_code.erase(0, position + 1);
+                else pending_code = "";
+                std::cerr << line << std::endl;
+            }
+        }
+        store_program_binary(pending_key, id);
+
+        // cleanup
+        glDeleteShader(pending_shader);
+        pending_shader = 0;
+        pending_code.clear();
+    }
+    reflection.reflect(id);
 }
 
 void SimpleComputeShader::init_without_arguments() {
@@ -77,30 +140,34 @@ void SimpleComputeShader::wait() const {
     glMemoryBarrier(GL_ALL_BARRIER_BITS);
 }
 
+void SimpleComputeShader::wait(GLbitfield barriers) const {
+    glMemoryBarrier(barriers);
+}
+
 void SimpleComputeShader::bind_uniform(const char *name, const Texture &texture, int unit, int access_mode) const {
-    GLint location = glGetUniformLocation(id, name);
+    GLint location = reflection.uniform_location(name);
     glUniform1i(location, unit);
     texture.bind_compute(unit, access_mode);
 }
 
 void SimpleComputeShader::bind_uniform(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), (int) value);
+    glUniform1i(reflection.uniform_location(name), (int) value);
 }
 
 void SimpleComputeShader::bind_uniform(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1i(reflection.uniform_location(name), value);
 }
 
 void SimpleComputeShader::bind_uniform(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1f(reflection.uniform_location(name), value);
 }
 
 void SimpleComputeShader::bind_uniform(const std::string &name, float *value, int count) const {
-    glUniform1fv(glGetUniformLocation(id, name.c_str()), count, value);
+    glUniform1fv(reflection.uniform_location(name), count, value);
 }
 
 GLint SimpleComputeShader::get_location(const std::string &name) const {
-    return glGetUniformLocation(id, name.c_str());
+    return reflection.uniform_location(name);
 }
 
 void SimpleComputeShader::bind_uniform(GLint location, const Texture &texture, int unit, int access_mode) const {
@@ -120,12 +187,24 @@ void SimpleComputeShader::bind_uniform(GLint location, float value) const {
     glUniform1f(location, value);
 }
 
+void SimpleComputeShader::bind_uniform(const std::string &name, std::array<float, 3> vector) const {
+    bind_uniform(reflection.uniform_location(name), vector);
+}
+
+void SimpleComputeShader::bind_uniform(GLint location, std::array<float, 3> vector) const {
+    glUniform3f(location, vector[0], vector[1], vector[2]);
+}
+
 void SimpleComputeShader::bind_uniform(GLint location, float *value, int count) const {
     glUniform1fv(location, count, value);
 }
 
 GLint SimpleComputeShader::find_block_index(const std::string &name) const {
-    return glGetProgramResourceIndex(id, GL_SHADER_STORAGE_BLOCK, name.c_str());
+    return reflection.storage_block_index(name);
+}
+
+GLint SimpleComputeShader::find_block_array_stride(const std::string &name) const {
+    return reflection.storage_block_array_stride(name);
 }
 
 void SimpleComputeShader::bind_buffer(GLint location, const Buffer &buffer, int point) const {
@@ -136,3 +215,8 @@ void SimpleComputeShader::bind_buffer(GLint location, const Buffer &buffer, int
 void SimpleComputeShader::bind_buffer(const std::string &name, const Buffer &buffer, int point) const {
     bind_buffer(find_block_index(name), buffer, point);
 }
+
+void SimpleComputeShader::bind_uniform_block(const std::string &name, const Buffer &buffer, int point) const {
+    glUniformBlockBinding(id, reflection.uniform_block_index(name), point);
+    buffer.bind(point);
+}
@@ -1,9 +1,12 @@
 #ifndef GAME_OF_LIFE_SIMPLECOMPUTESHADER_H
 #define GAME_OF_LIFE_SIMPLECOMPUTESHADER_H
 
+#include <array>
 #include <string>
+#include <utility>
 #include "Texture.h"
 #include "Buffer.h"
+#include "ShaderReflection.h"
 
 #include <fstream>
 #include <iostream>
@@ -17,12 +20,39 @@ public:
 
     explicit SimpleComputeShader(const char *path);
 
+    // shaders own their program, they can be moved but not copied
+    SimpleComputeShader(const SimpleComputeShader &) = delete;
+    SimpleComputeShader &operator=(const SimpleComputeShader &) = delete;
+
+    SimpleComputeShader(SimpleComputeShader &&other) noexcept;
+
+    SimpleComputeShader &operator=(SimpleComputeShader &&other) noexcept;
+
+    ~SimpleComputeShader();
+
     /**
-     * Reads and compiles the shader. MUST be called after gflw has been initialized.
+     * Reads and compiles the shader, replacing the program of a previous call. MUST be called after gflw has been
+     * initialized.
      * @param arguments additional shader code that will be put after the version line in the shader, useful for constants
      */
     void init(const std::string &arguments);
 
+    /**
+     * First half of init(): reads the shader and hands it to the driver without waiting for the result, so a
+     * program can be built in the background while the previous one is still in use.
+     * @param arguments like in init(const std::string &)
+     */
+    void start_init(const std::string &arguments);
+
+    /**
+     * Whether finish_init() can be called without blocking. With GL_KHR_parallel_shader_compile this turns true once
+     * the driver threads are done, without it right away (the shader is compiled in finish_init() then).
+     */
+    bool init_ready() const;
+
+    // second half of init(): reports compile errors, queries and caches the program, the shader can be used afterwards
+    void finish_init();
+
     /**
      * Call to init(const std::string &) without any arguments.
      */
@@ -40,6 +70,14 @@ public:
     // wait for the compute shader to finish
     void wait() const;
 
+    /**
+     * Makes the writes of previous dispatches visible to the given kinds of accesses only, which is cheaper than
+     * waiting for everything.
+     * @param barriers bits of glMemoryBarrier, e.g. GL_SHADER_STORAGE_BARRIER_BIT if the next dispatch only reads
+     * the written buffers
+     */
+    void wait(GLbitfield barriers) const;
+
     /**
      * Binds a texture to a uniform in the compute shader
      * @param name name of the uniform
@@ -80,8 +118,15 @@ public:
     void bind_uniform(const std::string &name, float *value, int count) const;
 
     /**
-     * Returns the location of the uniform with the given name, can be used to cache
-     * locations to save on glGetUniformLocation calls.
+     * Binds an vec3 vector to a uniform in the shaders.
+     * @param name name of the uniform
+     * @param vector vector to bind
+     */
+    void bind_uniform(const std::string &name, std::array<float, 3> vector) const;
+
+    /**
+     * Returns the location of the uniform with the given name, looked up in the locations that were queried once
+     * after linking.
      */
     GLint get_location(const std::string &name) const;
 
@@ -124,13 +169,43 @@ public:
      */
     void bind_uniform(GLint location, float *value, int count) const;
 
+    /**
+     * Binds an vec3 vector to a uniform in the shaders.
+     * @param location location of the uniform
+     * @param vector vector to bind
+     */
+    void bind_uniform(GLint location, std::array<float, 3> vector) const;
+
     GLint find_block_index(const std::string &name) const;
 
+    // stride of the array in a shader storage block, see ShaderReflection::storage_block_array_stride
+    GLint find_block_array_stride(const std::string &name) const;
+
     void bind_buffer(GLint location, const Buffer &buffer, int point) const;
 
     void bind_buffer(const std::string &name, const Buffer &buffer, int point) const;
+
+    /**
+     * Binds a uniform buffer to a uniform block of the shaders.
+     * @param name name of the uniform block
+     * @param buffer buffer of type GL_UNIFORM_BUFFER
+     * @param point uniform buffer binding point
+     */
+    void bind_uniform_block(const std::string &name, const Buffer &buffer, int point) const;
+    // deletes the program now instead of with the shader
+    void delete_program();
+
 private:
     const char *path;
+
+    // queried once after linking, all lookups by name go through it
+    ShaderReflection reflection;
+
+    // between start_init() and finish_init(): the shader attached to the program (0 if it was loaded from the
+    // program cache), its code for the error messages and the key its binary is cached under
+    unsigned int pending_shader = 0;
+    std::string pending_code;
+    std::string pending_key;
 };
 
 #endif //GAME_OF_LIFE_SIMPLECOMPUTESHADER_H
@@ -1,6 +1,9 @@
 #include "SimpleShader.h"
 
 #include <glad/glad.h>
+#include "Arguments.h"
+#include "GlObjects.h"
+#include "ProgramCache.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -11,7 +14,70 @@ SimpleShader::SimpleShader() : id(0), vertexPath(""), fragmentPath("") {}
 SimpleShader::SimpleShader(const char *vertexPath, const char *fragmentPath) : vertexPath(vertexPath),
                                                                                fragmentPath(fragmentPath), id(0) {}
 
+SimpleShader::SimpleShader(SimpleShader &&other) noexcept
+        : id(std::exchange(other.id, 0)), vertexPath(other.vertexPath), fragmentPath(other.fragmentPath),
+          reflection(std::move(other.reflection)), pending_vertex(std::exchange(other.pending_vertex, 0)),
+          pending_fragment(std::exchange(other.pending_fragment, 0)),
+          pending_vertex_code(std::move(other.pending_vertex_code)),
+          pending_fragment_code(std::move(other.pending_fragment_code)), pending_key(std::move(other.pending_key)) {}
+
+SimpleShader &SimpleShader::operator=(SimpleShader &&other) noexcept {
+    if (this != &other) {
+        delete_program();
+        id = std::exchange(other.id, 0);
+        vertexPath = other.vertexPath;
+        fragmentPath = other.fragmentPath;
+        reflection = std::move(other.reflection);
+        pending_vertex = std::exchange(other.pending_vertex, 0);
+        pending_fragment = std::exchange(other.pending_fragment, 0);
+        pending_vertex_code = std::move(other.pending_vertex_code);
+        pending_fragment_code = std::move(other.pending_fragment_code);
+        pending_key = std::move(other.pending_key);
+    }
+    return *this;
+}
+
+SimpleShader::~SimpleShader() {
+    delete_program();
+}
+
+void SimpleShader::delete_program() {
+    if (!GL_CONTEXT_DESTROYED) {
+        if (pending_vertex != 0) glDeleteShader(pending_vertex);
+        if (pending_fragment != 0) glDeleteShader(pending_fragment);
+    }
+    pending_vertex = pending_fragment = 0;
+    if (id == 0) return;
+    GL_OBJECTS.programs.remove(0);
+    if (!GL_CONTEXT_DESTROYED) glDeleteProgram(id);
+    id = 0;
+}
+
+// prints the info log and the numbered code of a shader that failed to compile
+static void report_compile_errors(unsigned int shader, std::string code) {
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+        for (int i = 1; code.length() > 0; ++i) {
+            int position = code.find("\n");
+            std::string line = std::to_string(i) + "\t" + code.substr(0, position);
+            if (position >= 0) code.erase(0, position + 1);
+            else code = "";
+            std::cerr << line << std::endl;
+        }
+    }
+}
+
 void SimpleShader::init(const std::string &arguments) {
+    start_init(arguments);
+    finish_init();
+}
+
+void SimpleShader::start_init(const std::string &arguments) {
+    ProgramInitTimer timer;
     // read shader codes from the files
     std::string vertex_code;
     std::string fragment_code;
@@ -34,73 +100,65 @@ void SimpleShader::init(const std::string &arguments) {
         vertex_code = v_shader_stream.str();
         fragment_code = f_shader_stream.str();
 
-        // insert argument into shader code after version line (=first line)
-        std::string first_line = vertex_code.substr(0, vertex_code.find('\n') + 1);
-        vertex_code.erase(0, vertex_code.find('\n') + 1);
-        vertex_code = first_line + arguments + vertex_code;
-
-        first_line = fragment_code.substr(0, fragment_code.find('\n') + 1);
-        fragment_code.erase(0, fragment_code.find('\n') + 1);
-        fragment_code = first_line + arguments + fragment_code;
+        // insert argument into shader code after the version line
+        // (generated shaders start with comments, so this isn't necessarily the first line)
+        vertex_code.insert(after_version_line(vertex_code), arguments);
+        fragment_code.insert(after_version_line(fragment_code), arguments);
     } catch (const std::ifstream::failure &e) {
         std::cerr << "failed to read shader files" << std::endl;
     }
 
+    delete_program();
+    pending_key = program_cache_key({vertex_code, fragment_code});
+    id = load_program_binary(pending_key);
+    if (id != 0) {
+        GL_OBJECTS.programs.add(0);
+        return;
+    }
+
     const char *v_shader_code = vertex_code.c_str();
     const char *f_shader_code = fragment_code.c_str();
 
-    // compile shaders
-    unsigned int vertex, fragment;
+    // compile shaders, their status is only checked in finish_init() so the driver doesn't have to finish here
+    pending_vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(pending_vertex, 1, &v_shader_code, NULL);
+    glCompileShader(pending_vertex);
 
-    // vertex shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &v_shader_code, NULL);
-    glCompileShader(vertex);
+    pending_fragment = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(pending_fragment, 1, &f_shader_code, NULL);
+    glCompileShader(pending_fragment);
 
-    // check for compile errors while compiling the vertex shader
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
-        for (int i = 1; vertex_code.length() > 0; ++i) {
-            int position = vertex_code.find("\n");
-            std::string line = std::to_string(i) + "\t" + vertex_code.substr(0, position);
-            if (position >= 0) vertex_code.erase(0, position + 1);
-            else vertex_code = "";
-            std::cerr << line << std::endl;
-        }
-    }
-
-    // fragment shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &f_shader_code, NULL);
-    glCompileShader(fragment);
-
-    // check for compile errors while compiling the fragment shader
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
-        for (int i = 1; fragment_code.length() > 0; ++i) {
-            int position = fragment_code.find("\n");
-            std::string line = std::to_string(i) + "\t" + fragment_code.substr(0, position);
-            if (position >= 0) fragment_code.erase(0, position + 1);
-            else fragment_code = "";
-            std::cerr << line << std::endl;
-        }
-    }
+    pending_vertex_code = std::move(vertex_code);
+    pending_fragment_code = std::move(fragment_code);
 
     // create program
     id = glCreateProgram();
-    glAttachShader(id, vertex);
-    glAttachShader(id, fragment);
+    GL_OBJECTS.programs.add(0);
+    glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(id, pending_vertex);
+    glAttachShader(id, pending_fragment);
     glLinkProgram(id);
+}
 
-    // cleanup
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+bool SimpleShader::init_ready() const {
+    return program_link_completed(id);
+}
+
+void SimpleShader::finish_init() {
+    ProgramInitTimer timer;
+    if (pending_vertex != 0) {
+        report_compile_errors(pending_vertex, std::move(pending_vertex_code));
+        report_compile_errors(pending_fragment, std::move(pending_fragment_code));
+        store_program_binary(pending_key, id);
+
+        // cleanup
+        glDeleteShader(pending_vertex);
+        glDeleteShader(pending_fragment);
+        pending_vertex = pending_fragment = 0;
+        pending_vertex_code.clear();
+        pending_fragment_code.clear();
+    }
+    reflection.reflect(id);
 }
 
 void SimpleShader::init_without_arguments() {
@@ -112,19 +170,19 @@ void SimpleShader::use() const {
 }
 
 void SimpleShader::bind_uniform(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), (int) value);
+    glUniform1i(reflection.uniform_location(name), (int) value);
 }
 
 void SimpleShader::bind_uniform(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1i(reflection.uniform_location(name), value);
 }
 
 void SimpleShader::bind_uniform(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+    glUniform1f(reflection.uniform_location(name), value);
 }
 
 void SimpleShader::bind_uniform(const char *name, const Texture &texture, int unit) const {
-    GLint location = glGetUniformLocation(id, name);
+    GLint location = reflection.uniform_location(name);
     glUniform1i(location, unit);
     texture.bind(unit);
 }
@@ -143,11 +201,11 @@ void SimpleShader::bind_uniform(const std::string &name, std::array<float, 9> ma
 }
 
 void SimpleShader::bind_uniform(const std::string &name, float *value, int count) const {
-    glUniform1fv(glGetUniformLocation(id, name.c_str()), count, value);
+    glUniform1fv(reflection.uniform_location(name), count, value);
 }
 
 GLint SimpleShader::get_location(const std::string &name) const {
-    return glGetUniformLocation(id, name.c_str());
+    return reflection.uniform_location(name);
 }
 
 void SimpleShader::bind_uniform(GLint location, const Texture &texture, int unit) const {
@@ -180,7 +238,11 @@ void SimpleShader::bind_uniform(GLint location, std::array<float, 3> vector) con
 }
 
 GLint SimpleShader::find_block_index(const std::string &name) const {
-    return glGetProgramResourceIndex(id, GL_SHADER_STORAGE_BLOCK, name.c_str());
+    return reflection.storage_block_index(name);
+}
+
+GLint SimpleShader::find_block_array_stride(const std::string &name) const {
+    return reflection.storage_block_array_stride(name);
 }
 
 void SimpleShader::bind_buffer(GLint location, const Buffer &buffer, int point) const {
@@ -195,3 +257,8 @@ void SimpleShader::bind_buffer(const std::string &name, const Buffer &buffer, in
 void SimpleShader::bind_uniform(GLint location, std::array<float, 9> matrix) const {
     glUniformMatrix3fv(location, 1, false, matrix.data());
 }
+
+void SimpleShader::bind_uniform_block(const std::string &name, const Buffer &buffer, int point) const {
+    glUniformBlockBinding(id, reflection.uniform_block_index(name), point);
+    buffer.bind(point);
+}
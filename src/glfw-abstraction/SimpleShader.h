@@ -3,8 +3,10 @@
 
 #include <string>
 #include <array>
+#include <utility>
 #include "Texture.h"
 #include "Buffer.h"
+#include "ShaderReflection.h"
 
 class SimpleShader {
 public:
@@ -14,12 +16,39 @@ public:
 
     SimpleShader(const char *vertexPath, const char *fragmentPath);
 
+    // shaders own their program, they can be moved but not copied
+    SimpleShader(const SimpleShader &) = delete;
+    SimpleShader &operator=(const SimpleShader &) = delete;
+
+    SimpleShader(SimpleShader &&other) noexcept;
+
+    SimpleShader &operator=(SimpleShader &&other) noexcept;
+
+    virtual ~SimpleShader();
+
     /**
-     * Reads and compiles the shaders. MUST be called after gflw has been initialized.
+     * Reads and compiles the shaders, replacing the program of a previous call. MUST be called after gflw has been
+     * initialized.
      * @param arguments additional shader code that will be put after the version line in the shaders, useful for constants
      */
     virtual void init(const std::string &arguments);
 
+    /**
+     * First half of init(): reads the shaders and hands them to the driver without waiting for the result, so a
+     * program can be built in the background while the previous one is still in use.
+     * @param arguments like in init(const std::string &)
+     */
+    void start_init(const std::string &arguments);
+
+    /**
+     * Whether finish_init() can be called without blocking. With GL_KHR_parallel_shader_compile this turns true once
+     * the driver threads are done, without it right away (the shaders are compiled in finish_init() then).
+     */
+    bool init_ready() const;
+
+    // second half of init(): reports compile errors, queries and caches the program, the shader can be used afterwards
+    virtual void finish_init();
+
     /**
      * Call to init(const std::string &) without any arguments.
      */
@@ -87,8 +116,8 @@ public:
     void bind_uniform(const std::string &name, std::array<float, 9> matrix) const;
 
     /**
-     * Returns the location of the uniform with the given name, can be used to cache
-     * locations to save on glGetUniformLocation calls.
+     * Returns the location of the uniform with the given name, looked up in the locations that were queried once
+     * after linking.
      */
     GLint get_location(const std::string &name) const;
 
@@ -152,13 +181,38 @@ public:
 
     GLint find_block_index(const std::string &name) const;
 
+    // stride of the array in a shader storage block, see ShaderReflection::storage_block_array_stride
+    GLint find_block_array_stride(const std::string &name) const;
+
     void bind_buffer(GLint location, const Buffer &buffer, int point) const;
 
     void bind_buffer(const std::string &name, const Buffer &buffer, int point) const;
 
+    /**
+     * Binds a uniform buffer to a uniform block of the shaders.
+     * @param name name of the uniform block
+     * @param buffer buffer of type GL_UNIFORM_BUFFER
+     * @param point uniform buffer binding point
+     */
+    void bind_uniform_block(const std::string &name, const Buffer &buffer, int point) const;
+
+    // deletes the program now instead of with the shader
+    void delete_program();
+
 private:
     const char *vertexPath;
     const char *fragmentPath;
+
+    // queried once after linking, all lookups by name go through it
+    ShaderReflection reflection;
+
+    // between start_init() and finish_init(): the shaders attached to the program (0 if it was loaded from the
+    // program cache), their code for the error messages and the key the binary is cached under
+    unsigned int pending_vertex = 0;
+    unsigned int pending_fragment = 0;
+    std::string pending_vertex_code;
+    std::string pending_fragment_code;
+    std::string pending_key;
 };
 
 
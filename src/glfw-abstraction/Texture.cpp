@@ -2,35 +2,104 @@
 
 #include <glad/glad.h>
 #include <stddef.h>
+#include "GlObjects.h"
 
-Texture::Texture() : id(0), width(-1), height(-1), value_type(-1), mode(-1), type(-1) {}
+Texture::Texture() : id(0), width(-1), height(-1), depth(1), value_type(-1), mode(-1), type(-1),
+                     target(GL_TEXTURE_2D) {}
 
 Texture::Texture(int width, int height, int type, unsigned int value_type, unsigned int mode) : width(width),
                                                                                                 height(height),
+                                                                                                depth(1),
                                                                                                 type(type),
                                                                                                 value_type(value_type),
-                                                                                                mode(mode), id(-1) {}
+                                                                                                mode(mode), id(0),
+                                                                                                target(GL_TEXTURE_2D) {}
+
+Texture::Texture(int width, int height, int depth, int type, unsigned int value_type, unsigned int mode)
+        : id(0), width(width), height(height), depth(depth), value_type(value_type), mode(mode), type(type),
+          target(GL_TEXTURE_3D) {}
+
+Texture::Texture(Texture &&other) noexcept: id(std::exchange(other.id, 0)), width(other.width), height(other.height),
+                                            depth(other.depth), value_type(other.value_type), mode(other.mode),
+                                            type(other.type), target(other.target) {}
+
+Texture &Texture::operator=(Texture &&other) noexcept {
+    if (this != &other) {
+        delete_texture();
+        id = std::exchange(other.id, 0);
+        width = other.width;
+        height = other.height;
+        depth = other.depth;
+        value_type = other.value_type;
+        mode = other.mode;
+        type = other.type;
+        target = other.target;
+    }
+    return *this;
+}
+
+Texture::~Texture() {
+    delete_texture();
+}
 
 void Texture::init() {
+    // calling init again replaces the texture
+    delete_texture();
     glGenTextures(1, &id);
+    GL_OBJECTS.textures.add(bytes());
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, id);
+    glBindTexture(target, id);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, type, width, height, 0, mode, value_type, NULL);
+    if (target == GL_TEXTURE_3D) {
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexImage3D(target, 0, type, width, height, depth, 0, mode, value_type, NULL);
+    } else {
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(target, 0, type, width, height, 0, mode, value_type, NULL);
+    }
 }
 
 Texture::operator unsigned int() const {
     return id;
 }
 
+void Texture::delete_texture() {
+    if (id == 0) return;
+    GL_OBJECTS.textures.remove(bytes());
+    if (!GL_CONTEXT_DESTROYED) glDeleteTextures(1, &id);
+    id = 0;
+}
+
+long long Texture::bytes() const {
+    int bytes_per_pixel;
+    switch (type) {
+        case GL_RGBA32F:
+        case GL_RGBA32UI:
+            bytes_per_pixel = 16;
+            break;
+        case GL_RGB32F:
+            bytes_per_pixel = 12;
+            break;
+        case GL_RG32F:
+            bytes_per_pixel = 8;
+            break;
+        default:
+            // GL_R32F, GL_R32UI, GL_RGBA8, ...
+            bytes_per_pixel = 4;
+    }
+    return (long long) width * height * depth * bytes_per_pixel;
+}
+
 void Texture::bind(unsigned int unit) const {
     glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, id);
+    glBindTexture(target, id);
 }
 
 void Texture::bind_compute(int unit, int access_mode) const {
-    glBindImageTexture(unit, id, 0, GL_FALSE, 0, access_mode, type);
+    glBindImageTexture(unit, id, 0, target == GL_TEXTURE_3D ? GL_TRUE : GL_FALSE, 0, access_mode, type);
 }
\ No newline at end of file
@@ -3,11 +3,14 @@
 
 #include <vector>
 #include <glad/glad.h>
+#include <utility>
 
+// owns a gl texture, which is deleted with it, textures can be moved but not copied
 class Texture {
 public:
     unsigned int id;
-    int width, height;
+    // depth is 1 for 2D textures
+    int width, height, depth;
 
     Texture();
 
@@ -22,6 +25,23 @@ public:
      */
     Texture(int width, int height, int type, unsigned int value_type, unsigned int mode);
 
+    /**
+     * 3D texture on the gpu, e.g. a sampled volume. Unlike 2D textures it is filtered linearly and clamped to its
+     * edges, so sampling between the voxels interpolates them.
+     * @param depth depth of the texture in px, the other parameters are the ones of the 2D constructor
+     */
+    Texture(int width, int height, int depth, int type, unsigned int value_type, unsigned int mode);
+
+    Texture(const Texture &) = delete;
+    Texture &operator=(const Texture &) = delete;
+
+    Texture(Texture &&other) noexcept;
+
+    // deletes the texture this one owned before
+    Texture &operator=(Texture &&other) noexcept;
+
+    ~Texture();
+
     /**
      * Actually creates the texture. MUST be called after glfw has been initialized.
      */
@@ -36,15 +56,15 @@ public:
     // bind texture to a texture unit
     void bind(unsigned int unit) const;
 
-    // binds a texture to an image unit
+    // binds a texture to an image unit, all layers of 3D textures
     void bind_compute(int unit, int access_mode) const;
 
     // returns the data of a texture
     template<typename val, int vals_per_pixel>
     std::vector<val> get_data() {
-        std::vector<val> data(width * height * vals_per_pixel);
+        std::vector<val> data(width * height * depth * vals_per_pixel);
         bind(0);
-        glGetTexImage(GL_TEXTURE_2D, 0, mode, value_type, data.data());
+        glGetTexImage(target, 0, mode, value_type, data.data());
         return data;
     }
 
@@ -52,11 +72,23 @@ public:
     template<typename val>
     void set_data(val *values) {
         bind(0);
-        glTexImage2D(GL_TEXTURE_2D, 0, type, width, height, 0, mode, value_type, values);
+        if (target == GL_TEXTURE_3D) {
+            glTexImage3D(target, 0, type, width, height, depth, 0, mode, value_type, values);
+        } else {
+            glTexImage2D(target, 0, type, width, height, 0, mode, value_type, values);
+        }
     }
 
+    // deletes the gl object now instead of with the Texture
+    void delete_texture();
+
+    // memory of the texture on the gpu, estimated from its type
+    long long bytes() const;
+
 private:
     int value_type, mode, type;
+    // GL_TEXTURE_2D or GL_TEXTURE_3D
+    unsigned int target;
 };
 
 
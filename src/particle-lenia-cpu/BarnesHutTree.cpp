@@ -0,0 +1,228 @@
+#include "BarnesHutTree.h"
+
+#include <algorithm>
+#include <cmath>
+
+// particles closer together than 2^-32 of the bounding box end up in the same leaf
+const int BARNES_HUT_MAX_DEPTH = 32;
+// half width of the shell of K in multiples of sigma_k, K is below w_k * e^-9 outside of it
+const float BARNES_HUT_SHELL_WIDTH = 3.0f;
+
+template<int Dim>
+void BarnesHutTree<Dim>::build(const std::array<const float *, Dim> &positions, int num_particles) {
+    Vector corner;
+    float size = 0.0f;
+    for (int d = 0; d < Dim; ++d) {
+        sorted[d].assign(positions[d], positions[d] + num_particles);
+        scratch[d].resize(num_particles);
+        float min = 0, max = 0;
+        if (num_particles > 0) {
+            min = *std::min_element(sorted[d].begin(), sorted[d].end());
+            max = *std::max_element(sorted[d].begin(), sorted[d].end());
+        }
+        corner[d] = min;
+        size = std::max(size, max - min);
+    }
+    // particles on the upper border have to fall inside of the root
+    size = size * 1.0001f + 1e-6f;
+
+    nodes.clear();
+    nodes.emplace_back();
+    split(0, corner, size, 0, num_particles, 0);
+}
+
+template<int Dim>
+void BarnesHutTree<Dim>::split(int node, const Vector &corner, float size, int begin, int end, int depth) {
+    Vector centre_of_mass{};
+    for (int i = begin; i < end; ++i) {
+        for (int d = 0; d < Dim; ++d) centre_of_mass[d] += sorted[d][i];
+    }
+    for (int d = 0; d < Dim; ++d) centre_of_mass[d] /= (float) std::max(end - begin, 1);
+    std::array<float, Dim * Dim> second_moment{};
+    for (int i = begin; i < end; ++i) {
+        for (int a = 0; a < Dim; ++a) {
+            for (int b = 0; b < Dim; ++b) {
+                second_moment[a * Dim + b] += (sorted[a][i] - centre_of_mass[a]) * (sorted[b][i] - centre_of_mass[b]);
+            }
+        }
+    }
+    nodes[node] = Node{centre_of_mass, second_moment, size, begin, end, -1};
+    if (end - begin <= leaf_size || depth >= BARNES_HUT_MAX_DEPTH) return;
+
+    // counting sort of the particles by child, bit d of the child is set for the upper half in dimension d
+    const int num_children = 1 << Dim;
+    const float half = 0.5f * size;
+    auto child_of = [&](int i) {
+        int child = 0;
+        for (int d = 0; d < Dim; ++d) {
+            if (sorted[d][i] >= corner[d] + half) child |= 1 << d;
+        }
+        return child;
+    };
+    std::array<int, (1 << Dim) + 1> child_start{};
+    for (int i = begin; i < end; ++i) ++child_start[child_of(i) + 1];
+    child_start[0] = begin;
+    for (int c = 0; c < num_children; ++c) child_start[c + 1] += child_start[c];
+
+    std::array<int, 1 << Dim> offset;
+    std::copy(child_start.begin(), child_start.end() - 1, offset.begin());
+    for (int i = begin; i < end; ++i) {
+        int target = offset[child_of(i)]++;
+        for (int d = 0; d < Dim; ++d) scratch[d][target] = sorted[d][i];
+    }
+    for (int d = 0; d < Dim; ++d) {
+        std::copy(scratch[d].begin() + begin, scratch[d].begin() + end, sorted[d].begin() + begin);
+    }
+
+    // nodes may be reallocated by the recursion, so only indices are kept
+    int first_child = (int) nodes.size();
+    nodes[node].first_child = first_child;
+    nodes.resize(nodes.size() + num_children);
+    for (int c = 0; c < num_children; ++c) {
+        Vector child_corner = corner;
+        for (int d = 0; d < Dim; ++d) {
+            if (c & (1 << d)) child_corner[d] += half;
+        }
+        split(first_child + c, child_corner, half, child_start[c], child_start[c + 1], depth + 1);
+    }
+}
+
+// exp underflows to 0 for these arguments, which is a slow path of the math library
+static float gaussian(float t, float sigma_k2) {
+    float exponent = -t * t / sigma_k2;
+    return exponent < -87.0f ? 0.0f : std::exp(exponent);
+}
+
+// adds K and its gradient for count particles at a distance of norm in direction delta
+template<int Dim>
+static void add_particles(const FieldParameters &parameters, const std::array<float, Dim> &delta, float norm,
+                          float count, float &u, std::array<float, Dim> &grad_u) {
+    float t = norm - parameters.mu_k;
+    float k = count * parameters.w_k * gaussian(t, parameters.sigma_k2);
+    u += k;
+    // the direction is undefined for particles directly at the position, their contribution is zero
+    if (norm >= parameters.r_distance) {
+        float k_derivative = -2.0f * t / parameters.sigma_k2 * k / norm;
+        for (int d = 0; d < Dim; ++d) grad_u[d] += k_derivative * delta[d];
+    }
+}
+
+/*
+ * Adds the second order term of the Taylor expansion around the centre of mass, 1/2 sum_ab M_ab d_a d_b K(|delta|).
+ * For a radial function the Hessian is K'' n n^T + K' / r (I - n n^T), so the term is
+ * 1/2 (A(r) delta^T M delta / r^2 + B(r) tr M) with A = K'' - K' / r and B = K' / r.
+ */
+template<int Dim>
+static void add_second_moment(const FieldParameters &parameters, const std::array<float, Dim> &delta, float norm,
+                              const std::array<float, Dim * Dim> &moment, float &u, std::array<float, Dim> &grad_u) {
+    float t = norm - parameters.mu_k;
+    float s = 1.0f / parameters.sigma_k2;
+    float k = parameters.w_k * gaussian(t, parameters.sigma_k2);
+    if (k == 0.0f) return;
+    float k1 = -2.0f * t * s * k;
+    float k2 = (4.0f * t * t * s * s - 2.0f * s) * k;
+    float k3 = (-8.0f * t * t * t * s * s * s + 12.0f * t * s * s) * k;
+
+    std::array<float, Dim> moment_delta{};
+    float delta_moment_delta = 0.0f, trace = 0.0f;
+    for (int a = 0; a < Dim; ++a) {
+        for (int b = 0; b < Dim; ++b) moment_delta[a] += moment[a * Dim + b] * delta[b];
+        delta_moment_delta += delta[a] * moment_delta[a];
+        trace += moment[a * Dim + a];
+    }
+
+    float inverse = 1.0f / norm;
+    float inverse2 = inverse * inverse;
+    float a_over_r2 = (k2 - k1 * inverse) * inverse2;
+    float b = k1 * inverse;
+    u += 0.5f * (a_over_r2 * delta_moment_delta + b * trace);
+
+    // derivatives with respect to r of A / r^2 and B, turned into gradients by multiplying with delta / r
+    float a_over_r2_derivative = (k3 - k2 * inverse + k1 * inverse2) * inverse2 - 2.0f * a_over_r2 * inverse;
+    float b_derivative = (k2 - k1 * inverse) * inverse;
+    float radial = 0.5f * (a_over_r2_derivative * delta_moment_delta + b_derivative * trace) * inverse;
+    for (int a = 0; a < Dim; ++a) grad_u[a] += radial * delta[a] + a_over_r2 * moment_delta[a];
+}
+
+template<int Dim>
+void BarnesHutTree<Dim>::add_far_field(const FieldParameters &parameters, float theta, const Vector &position,
+                                       float &u, Vector &grad_u, std::vector<std::pair<int, int>> &near) const {
+    near.clear();
+
+    // K changes on the scale of sigma_k within its shell, so nodes within the shell also have to be small compared to
+    // sigma_k unless none of their particles can be in it
+    const float sigma_k = std::sqrt(parameters.sigma_k2);
+    auto outside_shell = [&](float norm, float size) {
+        float extent = size * std::sqrt((float) Dim);
+        return norm + extent < parameters.mu_k - BARNES_HUT_SHELL_WIDTH * sigma_k ||
+               norm - extent > parameters.mu_k + BARNES_HUT_SHELL_WIDTH * sigma_k;
+    };
+
+    std::array<int, BARNES_HUT_MAX_DEPTH * ((1 << Dim) - 1) + 1> stack;
+    int stack_size = 0;
+    if (!nodes.empty()) stack[stack_size++] = 0;
+
+    Vector delta;
+    while (stack_size > 0) {
+        const Node &node = nodes[stack[--stack_size]];
+        if (node.begin == node.end) continue;
+
+        float norm2 = 0.0f;
+        for (int d = 0; d < Dim; ++d) {
+            delta[d] = position[d] - node.centre_of_mass[d];
+            norm2 += delta[d] * delta[d];
+        }
+
+        float size2 = node.size * node.size;
+        bool small = size2 < theta * theta * parameters.sigma_k2;
+        if (size2 < theta * theta * norm2 && (small || outside_shell(std::sqrt(norm2), node.size))) {
+            float norm = std::sqrt(norm2);
+            add_particles<Dim>(parameters, delta, norm, (float) (node.end - node.begin), u, grad_u);
+            // the expansion only converges for nodes that are small compared to sigma_k, outside of the shell the
+            // monopole is already below count * K at the edge of the shell
+            if (small) add_second_moment<Dim>(parameters, delta, norm, node.second_moment, u, grad_u);
+        } else if (node.first_child >= 0) {
+            // pushed in reverse, so the children are visited in the order of the sorted particles
+            for (int c = (1 << Dim) - 1; c >= 0; --c) stack[stack_size++] = node.first_child + c;
+        } else if (!near.empty() && near.back().second == node.begin) {
+            near.back().second = node.end;
+        } else {
+            near.emplace_back(node.begin, node.end);
+        }
+    }
+}
+
+template<int Dim>
+void BarnesHutTree<Dim>::add_U(const FieldParameters &parameters, float theta, const Vector &position, float &u,
+                               Vector &grad_u) const {
+    std::vector<std::pair<int, int>> near;
+    add_far_field(parameters, theta, position, u, grad_u, near);
+
+    Vector delta;
+    for (const std::pair<int, int> &range: near) {
+        for (int i = range.first; i < range.second; ++i) {
+            float norm2 = 0.0f;
+            for (int d = 0; d < Dim; ++d) {
+                delta[d] = position[d] - sorted[d][i];
+                norm2 += delta[d] * delta[d];
+            }
+            add_particles<Dim>(parameters, delta, std::sqrt(norm2), 1.0f, u, grad_u);
+        }
+    }
+}
+
+template<int Dim>
+const std::vector<float> &BarnesHutTree<Dim>::sorted_coordinates(int dimension) const {
+    return sorted[dimension];
+}
+
+template<int Dim>
+int BarnesHutTree<Dim>::num_nodes() const {
+    return (int) nodes.size();
+}
+
+template
+class BarnesHutTree<2>;
+
+template
+class BarnesHutTree<3>;
@@ -0,0 +1,76 @@
+#ifndef PARTICLE_LENIA_BARNESHUTTREE_H
+#define PARTICLE_LENIA_BARNESHUTTREE_H
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "FieldKernel.h"
+
+/**
+ * Quadtree (Dim = 2) or octree (Dim = 3) over the particles that approximates the field U.
+ * Nodes that appear small from a position (edge length < theta * distance to their centre of mass) contribute
+ * as if all of their particles were at the centre of mass, plus a correction with the second moment of the particles
+ * around it (K is a narrow shell, the monopole alone is off by about size^2 / sigma_k^2 within the shell). U then costs
+ * O(log N) per position instead of O(N).
+ * The repulsion is short range and isn't handled by the tree.
+ */
+template<int Dim>
+class BarnesHutTree {
+public:
+    typedef std::array<float, Dim> Vector;
+
+    // nodes with at most this many particles aren't split any further, leaves are summed up exactly
+    int leaf_size = 16;
+
+    /**
+     * Rebuilds the tree from scratch.
+     * @param positions one array of coordinates per dimension
+     */
+    void build(const std::array<const float *, Dim> &positions, int num_particles);
+
+    /**
+     * Adds U and its gradient at a position.
+     * @param theta opening angle, 0 sums up every particle exactly
+     */
+    void add_U(const FieldParameters &parameters, float theta, const Vector &position, float &u,
+               Vector &grad_u) const;
+
+    /**
+     * Adds the contribution of all approximated nodes to U and its gradient, the particles of the leaves that have
+     * to be summed up exactly are returned instead, so they can be passed to a field kernel.
+     * @param near output, ranges of sorted_coordinates, adjacent leaves are merged into one range
+     */
+    void add_far_field(const FieldParameters &parameters, float theta, const Vector &position, float &u,
+                       Vector &grad_u, std::vector<std::pair<int, int>> &near) const;
+
+    // coordinates of the particles in the order of the leaves
+    const std::vector<float> &sorted_coordinates(int dimension) const;
+
+    int num_nodes() const;
+
+private:
+    struct Node {
+        Vector centre_of_mass;
+        // sum of the outer products of the particle offsets from the centre of mass
+        std::array<float, Dim * Dim> second_moment;
+        // edge length of the cube of the node
+        float size;
+        // the sorted particles [begin, end) lie in the node
+        int begin;
+        int end;
+        // index of the first of the 2^Dim children, -1 for leaves
+        int first_child;
+    };
+
+    // splits the node recursively until it is a leaf
+    void split(int node, const Vector &corner, float size, int begin, int end, int depth);
+
+    std::vector<Node> nodes;
+    // particles sorted by node
+    std::array<std::vector<float>, Dim> sorted;
+    std::array<std::vector<float>, Dim> scratch;
+};
+
+
+#endif //PARTICLE_LENIA_BARNESHUTTREE_H
@@ -0,0 +1,73 @@
+#include "CellList.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CellList::build(const float *xs, const float *ys, int num_particles, float minimum_cell_size) {
+    min_x = min_y = 0;
+    float max_x = 0, max_y = 0;
+    if (num_particles > 0) {
+        min_x = max_x = xs[0];
+        min_y = max_y = ys[0];
+    }
+    for (int i = 1; i < num_particles; ++i) {
+        min_x = std::min(min_x, xs[i]);
+        max_x = std::max(max_x, xs[i]);
+        min_y = std::min(min_y, ys[i]);
+        max_y = std::max(max_y, ys[i]);
+    }
+
+    // limit the number of cells, so sparse particles don't need huge amounts of memory
+    cell_size = minimum_cell_size;
+    const double max_cells = std::max(4.0 * num_particles, 1024.0);
+    while (std::floor((max_x - min_x) / cell_size + 1.0) * std::floor((max_y - min_y) / cell_size + 1.0) > max_cells) {
+        cell_size *= 2;
+    }
+    cells_x = (int) ((max_x - min_x) / cell_size) + 1;
+    cells_y = (int) ((max_y - min_y) / cell_size) + 1;
+
+    // counting sort by cell
+    std::vector<int> cells(num_particles);
+    cell_start.assign(num_cells() + 1, 0);
+    for (int i = 0; i < num_particles; ++i) {
+        cells[i] = cell_of(xs[i], ys[i]);
+        ++cell_start[cells[i] + 1];
+    }
+    for (int c = 0; c < num_cells(); ++c) cell_start[c + 1] += cell_start[c];
+
+    std::vector<int> offset(cell_start.begin(), cell_start.end() - 1);
+    x.resize(num_particles);
+    y.resize(num_particles);
+    index.resize(num_particles);
+    for (int i = 0; i < num_particles; ++i) {
+        int sorted = offset[cells[i]]++;
+        x[sorted] = xs[i];
+        y[sorted] = ys[i];
+        index[sorted] = i;
+    }
+}
+
+int CellList::num_cells() const {
+    return cells_x * cells_y;
+}
+
+int CellList::cell_of(float position_x, float position_y) const {
+    int cx = std::min(std::max((int) std::floor((position_x - min_x) / cell_size), 0), cells_x - 1);
+    int cy = std::min(std::max((int) std::floor((position_y - min_y) / cell_size), 0), cells_y - 1);
+    return cy * cells_x + cx;
+}
+
+int CellList::neighbour_ranges(int cell, std::array<std::pair<int, int>, 3> &ranges) const {
+    int cx = cell % cells_x;
+    int cy = cell / cells_x;
+    int first_x = std::max(cx - 1, 0);
+    int last_x = std::min(cx + 1, cells_x - 1);
+
+    int count = 0;
+    for (int row = std::max(cy - 1, 0); row <= std::min(cy + 1, cells_y - 1); ++row) {
+        int begin = cell_start[row * cells_x + first_x];
+        int end = cell_start[row * cells_x + last_x + 1];
+        if (begin < end) ranges[count++] = std::make_pair(begin, end);
+    }
+    return count;
+}
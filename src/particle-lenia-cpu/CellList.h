@@ -0,0 +1,49 @@
+#ifndef PARTICLE_LENIA_CELLLIST_H
+#define PARTICLE_LENIA_CELLLIST_H
+
+#include <array>
+#include <utility>
+#include <vector>
+
+/**
+ * Uniform grid over the bounding box of the particles, particles are sorted by their cell with a counting sort.
+ * All particles within cell_size of a position lie in the 3x3 cells around the cell of the position, and since the
+ * cells are stored row by row these are three contiguous ranges of the sorted particles.
+ */
+class CellList {
+public:
+    // sorted particle positions
+    std::vector<float> x;
+    std::vector<float> y;
+    // original index of every sorted particle
+    std::vector<int> index;
+    // sorted particles of cell c are [cell_start[c], cell_start[c + 1])
+    std::vector<int> cell_start;
+
+    int cells_x = 0;
+    int cells_y = 0;
+    float min_x = 0;
+    float min_y = 0;
+    float cell_size = 1;
+
+    /**
+     * Bins the particles, the grid is rebuilt from scratch on every call.
+     * @param cell_size minimum edge length of the cells, it is increased if the grid would need more than
+     * max(4 * num_particles, 1024) cells (e.g. for a few particles that are far apart)
+     */
+    void build(const float *xs, const float *ys, int num_particles, float cell_size);
+
+    int num_cells() const;
+
+    // returns the cell that contains the position, positions outside of the grid are clamped to the border cells
+    int cell_of(float position_x, float position_y) const;
+
+    /**
+     * Writes the ranges of sorted particles in the 3x3 cells around a cell.
+     * @return number of ranges written (rows outside of the grid are skipped)
+     */
+    int neighbour_ranges(int cell, std::array<std::pair<int, int>, 3> &ranges) const;
+};
+
+
+#endif //PARTICLE_LENIA_CELLLIST_H
@@ -0,0 +1,49 @@
+#include "Fft.h"
+
+#include <cmath>
+#include <utility>
+
+Fft::Fft(int size) : n(size), bit_reversed(size), twiddles(size / 2) {
+    int bits = 0;
+    while ((1 << bits) < n) ++bits;
+    for (int i = 0; i < n; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        bit_reversed[i] = reversed;
+    }
+    // computed in double precision, a recurrence would accumulate rounding errors over the large transforms
+    for (int k = 0; k < n / 2; ++k) {
+        double angle = -2.0 * M_PI * k / n;
+        twiddles[k] = std::complex<float>((float) std::cos(angle), (float) std::sin(angle));
+    }
+}
+
+void Fft::transform(std::complex<float> *values, bool inverse) const {
+    for (int i = 0; i < n; ++i) {
+        if (i < bit_reversed[i]) std::swap(values[i], values[bit_reversed[i]]);
+    }
+
+    for (int length = 2; length <= n; length *= 2) {
+        int half = length / 2;
+        int stride = n / length;
+        for (int start = 0; start < n; start += length) {
+            for (int k = 0; k < half; ++k) {
+                std::complex<float> twiddle = twiddles[k * stride];
+                if (inverse) twiddle = std::conj(twiddle);
+                std::complex<float> even = values[start + k];
+                // written out, std::complex multiplication checks for infinities and nans which is a lot slower
+                const std::complex<float> &v = values[start + k + half];
+                std::complex<float> odd(v.real() * twiddle.real() - v.imag() * twiddle.imag(),
+                                        v.real() * twiddle.imag() + v.imag() * twiddle.real());
+                values[start + k] = even + odd;
+                values[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+int Fft::size() const {
+    return n;
+}
@@ -0,0 +1,35 @@
+#ifndef PARTICLE_LENIA_FFT_H
+#define PARTICLE_LENIA_FFT_H
+
+#include <complex>
+#include <vector>
+
+/**
+ * Iterative radix-2 fast fourier transform of a fixed size.
+ * The bit reversal permutation and the twiddle factors are computed once in the constructor, so one instance can be
+ * shared by all threads that transform arrays of its size.
+ */
+class Fft {
+public:
+    /**
+     * @param size number of values per transform, has to be a power of two
+     */
+    explicit Fft(int size);
+
+    /**
+     * Transforms the values in place.
+     * @param inverse runs the inverse transform, which is NOT divided by size
+     */
+    void transform(std::complex<float> *values, bool inverse) const;
+
+    int size() const;
+
+private:
+    int n;
+    std::vector<int> bit_reversed;
+    // exp(-2 pi i k / n) for k < n / 2
+    std::vector<std::complex<float>> twiddles;
+};
+
+
+#endif //PARTICLE_LENIA_FFT_H
@@ -0,0 +1,133 @@
+#include "FieldKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+void field_kernel_scalar(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                         const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+    for (int q = 0; q < num_queries; ++q) sums[q] = FieldSums{0, 0, 0, 0, 0, 0};
+
+    for (int tile = 0; tile < num_particles; tile += FIELD_KERNEL_TILE) {
+        int tile_end = std::min(tile + FIELD_KERNEL_TILE, num_particles);
+        for (int q = 0; q < num_queries; ++q) {
+            FieldSums &sum = sums[q];
+            for (int j = tile; j < tile_end; ++j) {
+                float dx = query_x[q] - xs[j];
+                float dy = query_y[q] - ys[j];
+                float norm = std::sqrt(dx * dx + dy * dy);
+                float t = norm - parameters.mu_k;
+                float k = parameters.w_k * std::exp(-t * t / parameters.sigma_k2);
+                sum.u += k;
+                // the direction is undefined for particles directly at the position, their contribution is zero
+                if (norm >= parameters.r_distance) {
+                    float overlap = std::max(1.0f - norm, 0.0f);
+                    float k_derivative = -2.0f * t / parameters.sigma_k2 * k / norm;
+                    float repulsion_derivative = -2.0f * overlap / norm;
+                    sum.r += overlap * overlap;
+                    sum.grad_u_x += k_derivative * dx;
+                    sum.grad_u_y += k_derivative * dy;
+                    sum.grad_r_x += repulsion_derivative * dx;
+                    sum.grad_r_y += repulsion_derivative * dy;
+                }
+            }
+        }
+    }
+}
+
+void pair_kernel_scalar(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin, int end,
+                        const FieldSumArrays &sums) {
+    FieldSums sum{0, 0, 0, 0, 0, 0};
+    for (int j = begin; j < end; ++j) {
+        float dx = xs[i] - xs[j];
+        float dy = ys[i] - ys[j];
+        float norm = std::sqrt(dx * dx + dy * dy);
+        float t = norm - parameters.mu_k;
+        float k = parameters.w_k * std::exp(-t * t / parameters.sigma_k2);
+        sum.u += k;
+        sums.u[j] += k;
+        // the direction is undefined for particles at the same position, their contribution is zero
+        if (norm >= parameters.r_distance) {
+            float overlap = std::max(1.0f - norm, 0.0f);
+            float k_derivative = -2.0f * t / parameters.sigma_k2 * k / norm;
+            float repulsion_derivative = -2.0f * overlap / norm;
+            sum.r += overlap * overlap;
+            sum.grad_u_x += k_derivative * dx;
+            sum.grad_u_y += k_derivative * dy;
+            sum.grad_r_x += repulsion_derivative * dx;
+            sum.grad_r_y += repulsion_derivative * dy;
+            sums.r[j] += overlap * overlap;
+            sums.grad_u_x[j] -= k_derivative * dx;
+            sums.grad_u_y[j] -= k_derivative * dy;
+            sums.grad_r_x[j] -= repulsion_derivative * dx;
+            sums.grad_r_y[j] -= repulsion_derivative * dy;
+        }
+    }
+    sums.u[i] += sum.u;
+    sums.r[i] += sum.r;
+    sums.grad_u_x[i] += sum.grad_u_x;
+    sums.grad_u_y[i] += sum.grad_u_y;
+    sums.grad_r_x[i] += sum.grad_r_x;
+    sums.grad_r_y[i] += sum.grad_r_y;
+}
+
+FieldKernelPath best_field_kernel_path() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+#ifdef PARTICLE_LENIA_AVX512
+    if (__builtin_cpu_supports("avx512f")) return FieldKernelPath::AVX512;
+#endif
+#ifdef PARTICLE_LENIA_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return FieldKernelPath::AVX2;
+#endif
+#endif
+    return FieldKernelPath::SCALAR;
+}
+
+FieldKernel get_field_kernel(FieldKernelPath &path) {
+    FieldKernelPath best = best_field_kernel_path();
+    if ((int) path > (int) best) path = best;
+
+    switch (path) {
+#ifdef PARTICLE_LENIA_AVX512
+        case FieldKernelPath::AVX512:
+            return field_kernel_avx512;
+#endif
+#ifdef PARTICLE_LENIA_AVX2
+        case FieldKernelPath::AVX2:
+            return field_kernel_avx2;
+#endif
+        default:
+            path = FieldKernelPath::SCALAR;
+            return field_kernel_scalar;
+    }
+}
+
+PairKernel get_pair_kernel(FieldKernelPath &path) {
+    FieldKernelPath best = best_field_kernel_path();
+    if ((int) path > (int) best) path = best;
+
+    switch (path) {
+#ifdef PARTICLE_LENIA_AVX512
+        case FieldKernelPath::AVX512:
+            return pair_kernel_avx512;
+#endif
+#ifdef PARTICLE_LENIA_AVX2
+        case FieldKernelPath::AVX2:
+            return pair_kernel_avx2;
+#endif
+        default:
+            path = FieldKernelPath::SCALAR;
+            return pair_kernel_scalar;
+    }
+}
+
+const char *field_kernel_path_name(FieldKernelPath path) {
+    switch (path) {
+        case FieldKernelPath::AVX512:
+            return "AVX-512";
+        case FieldKernelPath::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef PARTICLE_LENIA_FIELDKERNEL_H
+#define PARTICLE_LENIA_FIELDKERNEL_H
+
+// parameters of K and the repulsion that the all-pairs kernels need
+struct FieldParameters {
+    float w_k;
+    float mu_k;
+    float sigma_k2;
+    float r_distance;
+};
+
+// values accumulated over all particles for one query position
+struct FieldSums {
+    float u;
+    float r;
+    float grad_u_x, grad_u_y;
+    float grad_r_x, grad_r_y;
+};
+
+// sums of all particles as separate arrays, so the pair kernels can load and store the sums of consecutive particles
+struct FieldSumArrays {
+    float *u;
+    float *r;
+    float *grad_u_x, *grad_u_y;
+    float *grad_r_x, *grad_r_y;
+};
+
+enum class FieldKernelPath {
+    SCALAR, AVX2, AVX512
+};
+
+/**
+ * All-pairs kernel, calculates U, R and their gradients at every query position.
+ * @param xs x coordinates of the particles
+ * @param ys y coordinates of the particles
+ * @param num_particles number of particles
+ * @param query_x x coordinates of the query positions
+ * @param query_y y coordinates of the query positions
+ * @param num_queries number of query positions
+ * @param sums output, one entry per query position
+ */
+typedef void (*FieldKernel)(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                            const float *query_x, const float *query_y, int num_queries, FieldSums *sums);
+
+/**
+ * Symmetric pair kernel, evaluates the pairs of particle i with the particles [begin, end) once and adds each
+ * contribution to the sums of both particles. The gradients of the other particle get the opposite sign, they are
+ * taken with respect to its own position.
+ * @param i particle outside of [begin, end)
+ * @param sums sums of all particles, indexed like xs and ys
+ */
+typedef void (*PairKernel)(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin,
+                           int end, const FieldSumArrays &sums);
+
+// number of particles per tile of the j-loop, x and y of one tile take 8 KiB and stay in L1
+const int FIELD_KERNEL_TILE = 1024;
+
+void field_kernel_scalar(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                         const float *query_x, const float *query_y, int num_queries, FieldSums *sums);
+
+void pair_kernel_scalar(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin, int end,
+                        const FieldSumArrays &sums);
+
+#ifdef PARTICLE_LENIA_AVX2
+void field_kernel_avx2(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                       const float *query_x, const float *query_y, int num_queries, FieldSums *sums);
+
+void pair_kernel_avx2(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin, int end,
+                      const FieldSumArrays &sums);
+#endif
+
+#ifdef PARTICLE_LENIA_AVX512
+void field_kernel_avx512(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                         const float *query_x, const float *query_y, int num_queries, FieldSums *sums);
+
+void pair_kernel_avx512(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin,
+                        int end, const FieldSumArrays &sums);
+#endif
+
+// best path that was compiled in and that the host cpu supports
+FieldKernelPath best_field_kernel_path();
+
+// returns the kernel for the given path, falls back to the best supported path if it isn't available
+FieldKernel get_field_kernel(FieldKernelPath &path);
+
+// returns the pair kernel for the given path, falls back like get_field_kernel
+PairKernel get_pair_kernel(FieldKernelPath &path);
+
+const char *field_kernel_path_name(FieldKernelPath path);
+
+#endif //PARTICLE_LENIA_FIELDKERNEL_H
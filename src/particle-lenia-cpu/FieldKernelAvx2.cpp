@@ -0,0 +1,181 @@
+// compiled with -mavx2 -mfma, only called after checking that the host cpu supports both
+#include "FieldKernel.h"
+
+#if defined(PARTICLE_LENIA_AVX2) && defined(__AVX2__) && defined(__FMA__)
+
+#include <algorithm>
+#include <immintrin.h>
+
+// exp(x) for 8 floats, range reduction to x = n * ln(2) + r followed by the cephes polynomial for exp(r)
+// arguments below -87 return 0 instead of a denormal, denormals would slow down all following arithmetic
+static inline __m256 exp_avx2(__m256 x) {
+    __m256 normal = _mm256_cmp_ps(x, _mm256_set1_ps(-87.0f), _CMP_GT_OQ);
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.0f)), _mm256_set1_ps(88.0f));
+
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+
+    __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+    p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.0f)));
+
+    // 2^n is built directly in the exponent bits
+    __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_and_ps(_mm256_mul_ps(p, _mm256_castsi256_ps(exponent)), normal);
+}
+
+static inline float horizontal_sum(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+void field_kernel_avx2(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                       const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+    for (int q = 0; q < num_queries; ++q) sums[q] = FieldSums{0, 0, 0, 0, 0, 0};
+
+    const __m256 w_k = _mm256_set1_ps(parameters.w_k);
+    const __m256 mu_k = _mm256_set1_ps(parameters.mu_k);
+    const __m256 neg_inv_sigma_k2 = _mm256_set1_ps(-1.0f / parameters.sigma_k2);
+    const __m256 k_derivative_factor = _mm256_set1_ps(-2.0f / parameters.sigma_k2);
+    const __m256 r_distance = _mm256_set1_ps(parameters.r_distance);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minus_two = _mm256_set1_ps(-2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (int tile = 0; tile < num_particles; tile += FIELD_KERNEL_TILE) {
+        int tile_end = std::min(tile + FIELD_KERNEL_TILE, num_particles);
+        for (int q = 0; q < num_queries; ++q) {
+            const __m256 qx = _mm256_set1_ps(query_x[q]);
+            const __m256 qy = _mm256_set1_ps(query_y[q]);
+            __m256 u = zero, r = zero;
+            __m256 grad_u_x = zero, grad_u_y = zero, grad_r_x = zero, grad_r_y = zero;
+
+            for (int j = tile; j < tile_end; j += 8) {
+                // lanes past the end of the tile are loaded as zero and masked out of every sum
+                __m256i remaining = _mm256_set1_epi32(tile_end - j);
+                __m256i lane_mask_i = _mm256_cmpgt_epi32(remaining, lane);
+                __m256 lane_mask = _mm256_castsi256_ps(lane_mask_i);
+                __m256 x = j + 8 <= tile_end ? _mm256_loadu_ps(xs + j) : _mm256_maskload_ps(xs + j, lane_mask_i);
+                __m256 y = j + 8 <= tile_end ? _mm256_loadu_ps(ys + j) : _mm256_maskload_ps(ys + j, lane_mask_i);
+
+                __m256 dx = _mm256_sub_ps(qx, x);
+                __m256 dy = _mm256_sub_ps(qy, y);
+                __m256 norm = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)));
+                __m256 t = _mm256_sub_ps(norm, mu_k);
+                __m256 k = _mm256_and_ps(
+                        _mm256_mul_ps(w_k, exp_avx2(_mm256_mul_ps(_mm256_mul_ps(t, t), neg_inv_sigma_k2))),
+                        lane_mask);
+                u = _mm256_add_ps(u, k);
+
+                // the direction is undefined for particles directly at the position, their contribution is zero
+                __m256 valid = _mm256_and_ps(_mm256_cmp_ps(norm, r_distance, _CMP_GE_OQ), lane_mask);
+                __m256 inv_norm = _mm256_and_ps(_mm256_div_ps(one, norm), valid);
+                __m256 overlap = _mm256_max_ps(_mm256_sub_ps(one, norm), zero);
+                r = _mm256_add_ps(r, _mm256_and_ps(_mm256_mul_ps(overlap, overlap), valid));
+
+                __m256 k_derivative = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(k_derivative_factor, t), k), inv_norm);
+                __m256 repulsion_derivative = _mm256_mul_ps(_mm256_mul_ps(minus_two, overlap), inv_norm);
+                grad_u_x = _mm256_fmadd_ps(k_derivative, dx, grad_u_x);
+                grad_u_y = _mm256_fmadd_ps(k_derivative, dy, grad_u_y);
+                grad_r_x = _mm256_fmadd_ps(repulsion_derivative, dx, grad_r_x);
+                grad_r_y = _mm256_fmadd_ps(repulsion_derivative, dy, grad_r_y);
+            }
+
+            FieldSums &sum = sums[q];
+            sum.u += horizontal_sum(u);
+            sum.r += horizontal_sum(r);
+            sum.grad_u_x += horizontal_sum(grad_u_x);
+            sum.grad_u_y += horizontal_sum(grad_u_y);
+            sum.grad_r_x += horizontal_sum(grad_r_x);
+            sum.grad_r_y += horizontal_sum(grad_r_y);
+        }
+    }
+}
+
+// adds value to the masked lanes of 8 consecutive floats, all lanes when the mask is nullptr
+static inline void add_to(float *address, const __m256i *lane_mask, __m256 value) {
+    if (lane_mask) {
+        _mm256_maskstore_ps(address, *lane_mask, _mm256_add_ps(_mm256_maskload_ps(address, *lane_mask), value));
+    } else {
+        _mm256_storeu_ps(address, _mm256_add_ps(_mm256_loadu_ps(address), value));
+    }
+}
+
+void pair_kernel_avx2(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin, int end,
+                      const FieldSumArrays &sums) {
+    const __m256 w_k = _mm256_set1_ps(parameters.w_k);
+    const __m256 mu_k = _mm256_set1_ps(parameters.mu_k);
+    const __m256 neg_inv_sigma_k2 = _mm256_set1_ps(-1.0f / parameters.sigma_k2);
+    const __m256 k_derivative_factor = _mm256_set1_ps(-2.0f / parameters.sigma_k2);
+    const __m256 r_distance = _mm256_set1_ps(parameters.r_distance);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minus_two = _mm256_set1_ps(-2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    const __m256 qx = _mm256_set1_ps(xs[i]);
+    const __m256 qy = _mm256_set1_ps(ys[i]);
+    __m256 u = zero, r = zero;
+    __m256 grad_u_x = zero, grad_u_y = zero, grad_r_x = zero, grad_r_y = zero;
+
+    for (int j = begin; j < end; j += 8) {
+        // lanes past end are loaded as zero, never stored and masked out of every sum
+        __m256i lane_mask_i = _mm256_cmpgt_epi32(_mm256_set1_epi32(end - j), lane);
+        __m256 lane_mask = _mm256_castsi256_ps(lane_mask_i);
+        const __m256i *tail = j + 8 <= end ? nullptr : &lane_mask_i;
+        __m256 x = tail ? _mm256_maskload_ps(xs + j, lane_mask_i) : _mm256_loadu_ps(xs + j);
+        __m256 y = tail ? _mm256_maskload_ps(ys + j, lane_mask_i) : _mm256_loadu_ps(ys + j);
+
+        __m256 dx = _mm256_sub_ps(qx, x);
+        __m256 dy = _mm256_sub_ps(qy, y);
+        __m256 norm = _mm256_sqrt_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)));
+        __m256 t = _mm256_sub_ps(norm, mu_k);
+        __m256 k = _mm256_and_ps(_mm256_mul_ps(w_k, exp_avx2(_mm256_mul_ps(_mm256_mul_ps(t, t), neg_inv_sigma_k2))),
+                                 lane_mask);
+
+        // the direction is undefined for particles at the same position, their contribution is zero
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(norm, r_distance, _CMP_GE_OQ), lane_mask);
+        __m256 inv_norm = _mm256_and_ps(_mm256_div_ps(one, norm), valid);
+        __m256 overlap = _mm256_max_ps(_mm256_sub_ps(one, norm), zero);
+        __m256 repulsion = _mm256_and_ps(_mm256_mul_ps(overlap, overlap), valid);
+
+        __m256 k_derivative = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(k_derivative_factor, t), k), inv_norm);
+        __m256 repulsion_derivative = _mm256_mul_ps(_mm256_mul_ps(minus_two, overlap), inv_norm);
+        __m256 k_x = _mm256_mul_ps(k_derivative, dx);
+        __m256 k_y = _mm256_mul_ps(k_derivative, dy);
+        __m256 repulsion_x = _mm256_mul_ps(repulsion_derivative, dx);
+        __m256 repulsion_y = _mm256_mul_ps(repulsion_derivative, dy);
+
+        u = _mm256_add_ps(u, k);
+        r = _mm256_add_ps(r, repulsion);
+        grad_u_x = _mm256_add_ps(grad_u_x, k_x);
+        grad_u_y = _mm256_add_ps(grad_u_y, k_y);
+        grad_r_x = _mm256_add_ps(grad_r_x, repulsion_x);
+        grad_r_y = _mm256_add_ps(grad_r_y, repulsion_y);
+
+        add_to(sums.u + j, tail, k);
+        add_to(sums.r + j, tail, repulsion);
+        add_to(sums.grad_u_x + j, tail, _mm256_sub_ps(zero, k_x));
+        add_to(sums.grad_u_y + j, tail, _mm256_sub_ps(zero, k_y));
+        add_to(sums.grad_r_x + j, tail, _mm256_sub_ps(zero, repulsion_x));
+        add_to(sums.grad_r_y + j, tail, _mm256_sub_ps(zero, repulsion_y));
+    }
+
+    sums.u[i] += horizontal_sum(u);
+    sums.r[i] += horizontal_sum(r);
+    sums.grad_u_x[i] += horizontal_sum(grad_u_x);
+    sums.grad_u_y[i] += horizontal_sum(grad_u_y);
+    sums.grad_r_x[i] += horizontal_sum(grad_r_x);
+    sums.grad_r_y[i] += horizontal_sum(grad_r_y);
+}
+
+#endif
@@ -0,0 +1,162 @@
+// compiled with -mavx512f, only called after checking that the host cpu supports it
+#include "FieldKernel.h"
+
+#if defined(PARTICLE_LENIA_AVX512) && defined(__AVX512F__)
+
+#include <algorithm>
+#include <immintrin.h>
+
+// exp(x) for 16 floats, range reduction to x = n * ln(2) + r followed by the cephes polynomial for exp(r)
+// arguments below -87 return 0 instead of a denormal, denormals would slow down all following arithmetic
+static inline __m512 exp_avx512(__m512 x) {
+    __mmask16 normal = _mm512_cmp_ps_mask(x, _mm512_set1_ps(-87.0f), _CMP_GT_OQ);
+    x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-87.0f)), _mm512_set1_ps(88.0f));
+
+    __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+                                    _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+
+    __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+    p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.0f)));
+
+    // multiplies by 2^n
+    return _mm512_maskz_scalef_ps(normal, p, n);
+}
+
+void field_kernel_avx512(const FieldParameters &parameters, const float *xs, const float *ys, int num_particles,
+                         const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+    for (int q = 0; q < num_queries; ++q) sums[q] = FieldSums{0, 0, 0, 0, 0, 0};
+
+    const __m512 w_k = _mm512_set1_ps(parameters.w_k);
+    const __m512 mu_k = _mm512_set1_ps(parameters.mu_k);
+    const __m512 neg_inv_sigma_k2 = _mm512_set1_ps(-1.0f / parameters.sigma_k2);
+    const __m512 k_derivative_factor = _mm512_set1_ps(-2.0f / parameters.sigma_k2);
+    const __m512 r_distance = _mm512_set1_ps(parameters.r_distance);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 minus_two = _mm512_set1_ps(-2.0f);
+    const __m512 zero = _mm512_setzero_ps();
+
+    for (int tile = 0; tile < num_particles; tile += FIELD_KERNEL_TILE) {
+        int tile_end = std::min(tile + FIELD_KERNEL_TILE, num_particles);
+        for (int q = 0; q < num_queries; ++q) {
+            const __m512 qx = _mm512_set1_ps(query_x[q]);
+            const __m512 qy = _mm512_set1_ps(query_y[q]);
+            __m512 u = zero, r = zero;
+            __m512 grad_u_x = zero, grad_u_y = zero, grad_r_x = zero, grad_r_y = zero;
+
+            for (int j = tile; j < tile_end; j += 16) {
+                // lanes past the end of the tile are masked out of the loads and every sum
+                __mmask16 lanes = tile_end - j >= 16 ? (__mmask16) 0xffff
+                                                     : (__mmask16) ((1u << (tile_end - j)) - 1u);
+                __m512 x = _mm512_maskz_loadu_ps(lanes, xs + j);
+                __m512 y = _mm512_maskz_loadu_ps(lanes, ys + j);
+
+                __m512 dx = _mm512_sub_ps(qx, x);
+                __m512 dy = _mm512_sub_ps(qy, y);
+                __m512 norm = _mm512_sqrt_ps(_mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy)));
+                __m512 t = _mm512_sub_ps(norm, mu_k);
+                __m512 k = _mm512_maskz_mul_ps(lanes, w_k,
+                                               exp_avx512(_mm512_mul_ps(_mm512_mul_ps(t, t), neg_inv_sigma_k2)));
+                u = _mm512_add_ps(u, k);
+
+                // the direction is undefined for particles directly at the position, their contribution is zero
+                __mmask16 valid = _mm512_mask_cmp_ps_mask(lanes, norm, r_distance, _CMP_GE_OQ);
+                __m512 inv_norm = _mm512_maskz_div_ps(valid, one, norm);
+                __m512 overlap = _mm512_max_ps(_mm512_sub_ps(one, norm), zero);
+                r = _mm512_mask3_fmadd_ps(overlap, overlap, r, valid);
+
+                __m512 k_derivative = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(k_derivative_factor, t), k), inv_norm);
+                __m512 repulsion_derivative = _mm512_mul_ps(_mm512_mul_ps(minus_two, overlap), inv_norm);
+                grad_u_x = _mm512_fmadd_ps(k_derivative, dx, grad_u_x);
+                grad_u_y = _mm512_fmadd_ps(k_derivative, dy, grad_u_y);
+                grad_r_x = _mm512_fmadd_ps(repulsion_derivative, dx, grad_r_x);
+                grad_r_y = _mm512_fmadd_ps(repulsion_derivative, dy, grad_r_y);
+            }
+
+            FieldSums &sum = sums[q];
+            sum.u += _mm512_reduce_add_ps(u);
+            sum.r += _mm512_reduce_add_ps(r);
+            sum.grad_u_x += _mm512_reduce_add_ps(grad_u_x);
+            sum.grad_u_y += _mm512_reduce_add_ps(grad_u_y);
+            sum.grad_r_x += _mm512_reduce_add_ps(grad_r_x);
+            sum.grad_r_y += _mm512_reduce_add_ps(grad_r_y);
+        }
+    }
+}
+
+// adds value to the masked lanes of 16 consecutive floats
+static inline void add_to(float *address, __mmask16 lanes, __m512 value) {
+    _mm512_mask_storeu_ps(address, lanes, _mm512_add_ps(_mm512_maskz_loadu_ps(lanes, address), value));
+}
+
+void pair_kernel_avx512(const FieldParameters &parameters, const float *xs, const float *ys, int i, int begin,
+                        int end, const FieldSumArrays &sums) {
+    const __m512 w_k = _mm512_set1_ps(parameters.w_k);
+    const __m512 mu_k = _mm512_set1_ps(parameters.mu_k);
+    const __m512 neg_inv_sigma_k2 = _mm512_set1_ps(-1.0f / parameters.sigma_k2);
+    const __m512 k_derivative_factor = _mm512_set1_ps(-2.0f / parameters.sigma_k2);
+    const __m512 r_distance = _mm512_set1_ps(parameters.r_distance);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 minus_two = _mm512_set1_ps(-2.0f);
+    const __m512 zero = _mm512_setzero_ps();
+
+    const __m512 qx = _mm512_set1_ps(xs[i]);
+    const __m512 qy = _mm512_set1_ps(ys[i]);
+    __m512 u = zero, r = zero;
+    __m512 grad_u_x = zero, grad_u_y = zero, grad_r_x = zero, grad_r_y = zero;
+
+    for (int j = begin; j < end; j += 16) {
+        // lanes past end are masked out of the loads, the stores and every sum
+        __mmask16 lanes = end - j >= 16 ? (__mmask16) 0xffff : (__mmask16) ((1u << (end - j)) - 1u);
+        __m512 x = _mm512_maskz_loadu_ps(lanes, xs + j);
+        __m512 y = _mm512_maskz_loadu_ps(lanes, ys + j);
+
+        __m512 dx = _mm512_sub_ps(qx, x);
+        __m512 dy = _mm512_sub_ps(qy, y);
+        __m512 norm = _mm512_sqrt_ps(_mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy)));
+        __m512 t = _mm512_sub_ps(norm, mu_k);
+        __m512 k = _mm512_maskz_mul_ps(lanes, w_k, exp_avx512(_mm512_mul_ps(_mm512_mul_ps(t, t), neg_inv_sigma_k2)));
+
+        // the direction is undefined for particles at the same position, their contribution is zero
+        __mmask16 valid = _mm512_mask_cmp_ps_mask(lanes, norm, r_distance, _CMP_GE_OQ);
+        __m512 inv_norm = _mm512_maskz_div_ps(valid, one, norm);
+        __m512 overlap = _mm512_max_ps(_mm512_sub_ps(one, norm), zero);
+        __m512 repulsion = _mm512_maskz_mul_ps(valid, overlap, overlap);
+
+        __m512 k_derivative = _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(k_derivative_factor, t), k), inv_norm);
+        __m512 repulsion_derivative = _mm512_mul_ps(_mm512_mul_ps(minus_two, overlap), inv_norm);
+        __m512 k_x = _mm512_mul_ps(k_derivative, dx);
+        __m512 k_y = _mm512_mul_ps(k_derivative, dy);
+        __m512 repulsion_x = _mm512_mul_ps(repulsion_derivative, dx);
+        __m512 repulsion_y = _mm512_mul_ps(repulsion_derivative, dy);
+
+        u = _mm512_add_ps(u, k);
+        r = _mm512_add_ps(r, repulsion);
+        grad_u_x = _mm512_add_ps(grad_u_x, k_x);
+        grad_u_y = _mm512_add_ps(grad_u_y, k_y);
+        grad_r_x = _mm512_add_ps(grad_r_x, repulsion_x);
+        grad_r_y = _mm512_add_ps(grad_r_y, repulsion_y);
+
+        add_to(sums.u + j, lanes, k);
+        add_to(sums.r + j, lanes, repulsion);
+        add_to(sums.grad_u_x + j, lanes, _mm512_sub_ps(zero, k_x));
+        add_to(sums.grad_u_y + j, lanes, _mm512_sub_ps(zero, k_y));
+        add_to(sums.grad_r_x + j, lanes, _mm512_sub_ps(zero, repulsion_x));
+        add_to(sums.grad_r_y + j, lanes, _mm512_sub_ps(zero, repulsion_y));
+    }
+
+    sums.u[i] += _mm512_reduce_add_ps(u);
+    sums.r[i] += _mm512_reduce_add_ps(r);
+    sums.grad_u_x[i] += _mm512_reduce_add_ps(grad_u_x);
+    sums.grad_u_y[i] += _mm512_reduce_add_ps(grad_u_y);
+    sums.grad_r_x[i] += _mm512_reduce_add_ps(grad_r_x);
+    sums.grad_r_y[i] += _mm512_reduce_add_ps(grad_r_y);
+}
+
+#endif
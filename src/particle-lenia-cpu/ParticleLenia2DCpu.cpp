@@ -0,0 +1,485 @@
+#include "ParticleLenia2DCpu.h"
+
+#include <algorithm>
+
+ParticleLenia2DCpu::ParticleLenia2DCpu(int num_threads) : x(num_particles, 0.0f), y(num_particles, 0.0f),
+                                                           pool(new ThreadPool(num_threads)) {
+    set_kernel_path(FieldKernelPath::AVX512);
+}
+
+void ParticleLenia2DCpu::set_num_threads(int num_threads) {
+    pool.reset(new ThreadPool(num_threads));
+}
+
+int ParticleLenia2DCpu::get_num_threads() const {
+    return pool->size();
+}
+
+void ParticleLenia2DCpu::set_kernel_path(FieldKernelPath path) {
+    kernel = get_field_kernel(path);
+    pair_kernel = get_pair_kernel(path);
+    kernel_path = path;
+}
+
+FieldKernelPath ParticleLenia2DCpu::get_kernel_path() const {
+    return kernel_path;
+}
+
+void ParticleLenia2DCpu::reset_particles(float width, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<> distribution(-((double) width) * 0.3, ((double) width) * 0.3);
+    x.resize(num_particles);
+    y.resize(num_particles);
+    for (int i = 0; i < num_particles; ++i) {
+        x[i] = (float) distribution(rng);
+        y[i] = (float) distribution(rng);
+    }
+    verlet_radius = 0;
+}
+
+void ParticleLenia2DCpu::set_particles(const std::vector<float> &data) {
+    num_particles = (int) (data.size() / 2);
+    x.resize(num_particles);
+    y.resize(num_particles);
+    for (int i = 0; i < num_particles; ++i) {
+        x[i] = data[2 * i];
+        y[i] = data[2 * i + 1];
+    }
+    verlet_radius = 0;
+}
+
+std::vector<float> ParticleLenia2DCpu::get_particles() const {
+    std::vector<float> data(2 * num_particles);
+    for (int i = 0; i < num_particles; ++i) {
+        data[2 * i] = x[i];
+        data[2 * i + 1] = y[i];
+    }
+    return data;
+}
+
+std::array<float, 2> ParticleLenia2DCpu::U_and_R(float position_x, float position_y) const {
+    float u = 0.0f;
+    float r = 0.0f;
+    for (int i = 0; i < num_particles; ++i) {
+        float dx = x[i] - position_x;
+        float dy = y[i] - position_y;
+        float norm = std::sqrt(dx * dx + dy * dy);
+        u += K(norm);
+        if (norm >= r_distance) {
+            float overlap = std::max(1.0f - norm, 0.0f);
+            r += overlap * overlap;
+        }
+    }
+    return {u, r};
+}
+
+std::array<float, 4> ParticleLenia2DCpu::fields(float position_x, float position_y) const {
+    std::array<float, 2> ur = U_and_R(position_x, position_y);
+    float g = G(ur[0]);
+    float e = E(ur[1], g);
+    return {ur[0], ur[1], g, e};
+}
+
+std::array<float, 2> ParticleLenia2DCpu::gradient(float position_x, float position_y) const {
+    float e1 = fields(position_x + h, position_y)[3];
+    float e2 = fields(position_x - h, position_y)[3];
+    float e3 = fields(position_x, position_y + h)[3];
+    float e4 = fields(position_x, position_y - h)[3];
+
+    return {(e1 - e2) / h2, (e3 - e4) / h2};
+}
+
+std::array<float, 2> ParticleLenia2DCpu::analytic_gradient_of(float position_x, float position_y) const {
+    float u = 0.0f;
+    float grad_u_x = 0.0f, grad_u_y = 0.0f;
+    float grad_r_x = 0.0f, grad_r_y = 0.0f;
+    for (int i = 0; i < num_particles; ++i) {
+        float dx = position_x - x[i];
+        float dy = position_y - y[i];
+        float norm = std::sqrt(dx * dx + dy * dy);
+        u += K(norm);
+        // the direction is undefined for particles directly at the position, their contribution is zero
+        if (norm >= r_distance) {
+            float k = K_derivative(norm) / norm;
+            float rep = -2.0f * std::max(1.0f - norm, 0.0f) / norm;
+            grad_u_x += k * dx;
+            grad_u_y += k * dy;
+            grad_r_x += rep * dx;
+            grad_r_y += rep * dy;
+        }
+    }
+    float g = G_derivative(u);
+    return {grad_r_x - g * grad_u_x, grad_r_y - g * grad_u_y};
+}
+
+template<typename SumsAt>
+void ParticleLenia2DCpu::integrate(const float *particle_x, const float *particle_y, int count, float *updated_x,
+                                   float *updated_y, SumsAt sums_at) const {
+    if (analytic_gradient) {
+        std::vector<FieldSums> sums(count);
+        sums_at(particle_x, particle_y, count, sums.data());
+        for (int i = 0; i < count; ++i) {
+            float g = G_derivative(sums[i].u);
+            updated_x[i] = particle_x[i] - dt * (sums[i].grad_r_x - g * sums[i].grad_u_x);
+            updated_y[i] = particle_y[i] - dt * (sums[i].grad_r_y - g * sums[i].grad_u_y);
+        }
+    } else {
+        // the four central difference positions of every particle are evaluated in one go
+        std::vector<float> query_x(4 * count), query_y(4 * count);
+        for (int i = 0; i < count; ++i) {
+            float px = particle_x[i], py = particle_y[i];
+            query_x[4 * i] = px + h;
+            query_y[4 * i] = py;
+            query_x[4 * i + 1] = px - h;
+            query_y[4 * i + 1] = py;
+            query_x[4 * i + 2] = px;
+            query_y[4 * i + 2] = py + h;
+            query_x[4 * i + 3] = px;
+            query_y[4 * i + 3] = py - h;
+        }
+        std::vector<FieldSums> sums(4 * count);
+        sums_at(query_x.data(), query_y.data(), 4 * count, sums.data());
+        for (int i = 0; i < count; ++i) {
+            float e[4];
+            for (int k = 0; k < 4; ++k) e[k] = E(sums[4 * i + k].r, G(sums[4 * i + k].u));
+            updated_x[i] = particle_x[i] - dt * (e[0] - e[1]) / h2;
+            updated_y[i] = particle_y[i] - dt * (e[2] - e[3]) / h2;
+        }
+    }
+}
+
+void ParticleLenia2DCpu::step(int steps) {
+    x_updated.resize(num_particles);
+    y_updated.resize(num_particles);
+
+    for (int s = 0; s < steps; ++s) {
+        switch (neighbour_search) {
+            case NeighbourSearch::ALL_PAIRS:
+                step_all_pairs();
+                break;
+            case NeighbourSearch::SYMMETRIC_PAIRS:
+                step_symmetric_pairs();
+                break;
+            case NeighbourSearch::CELL_LIST:
+                step_cell_list();
+                break;
+            case NeighbourSearch::VERLET_LIST:
+                step_verlet_list();
+                break;
+            case NeighbourSearch::BARNES_HUT:
+                step_barnes_hut();
+                break;
+            case NeighbourSearch::PARTICLE_MESH:
+                step_particle_mesh();
+                break;
+        }
+        // the other searches move the particles without updating the verlet lists, they have to be rebuilt
+        if (neighbour_search != NeighbourSearch::VERLET_LIST) verlet_radius = 0;
+        std::swap(x, x_updated);
+        std::swap(y, y_updated);
+    }
+}
+
+void ParticleLenia2DCpu::step_all_pairs() {
+    const FieldParameters parameters = field_parameters();
+
+    // every particle only reads the old positions, so the particles can be updated in any order
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        integrate(x.data() + begin, y.data() + begin, end - begin, x_updated.data() + begin,
+                  y_updated.data() + begin, [&](const float *query_x, const float *query_y, int count,
+                                                FieldSums *sums) {
+                    kernel(parameters, x.data(), y.data(), num_particles, query_x, query_y, count, sums);
+                });
+    });
+}
+
+void ParticleLenia2DCpu::step_symmetric_pairs() {
+    // the central difference positions aren't particles, so there are no symmetric pairs to share
+    if (!analytic_gradient) {
+        step_all_pairs();
+        return;
+    }
+
+    const FieldParameters parameters = field_parameters();
+    const int n = num_particles;
+    const int num_slots = pool->size();
+    pair_sums.assign((size_t) num_slots * 6 * n, 0.0f);
+    auto slot_sums = [&](int slot) {
+        float *sums = pair_sums.data() + (size_t) slot * 6 * n;
+        return FieldSumArrays{sums, sums + n, sums + 2 * n, sums + 3 * n, sums + 4 * n, sums + 5 * n};
+    };
+
+    // one chunk per slot, so every slot is written by exactly one thread, whichever worker ends up running it
+    pool->parallel_for(0, num_slots, 1, [&](int first_slot, int last_slot) {
+        for (int slot = first_slot; slot < last_slot; ++slot) {
+            FieldSumArrays sums = slot_sums(slot);
+            // particle i is paired with all later particles, interleaving the rows over the slots balances the
+            // shrinking rows and the later particles are visited in tiles that stay in cache for all rows
+            for (int tile = 0; tile < n; tile += FIELD_KERNEL_TILE) {
+                int tile_end = std::min(tile + FIELD_KERNEL_TILE, n);
+                for (int i = slot; i < tile_end - 1; i += num_slots) {
+                    pair_kernel(parameters, x.data(), y.data(), i, std::max(i + 1, tile), tile_end, sums);
+                }
+            }
+        }
+    });
+
+    // the slots are always summed up in the same order, so the result only depends on the number of threads
+    pool->parallel_for(0, n, chunk_size, [&](int begin, int end) {
+        integrate(x.data() + begin, y.data() + begin, end - begin, x_updated.data() + begin,
+                  y_updated.data() + begin, [&](const float *, const float *, int count, FieldSums *sums) {
+                    for (int k = 0; k < count; ++k) {
+                        int i = begin + k;
+                        // the pairs leave out every particle itself, which adds K(0) to U (but nothing to R)
+                        FieldSums sum{K(0), 0, 0, 0, 0, 0};
+                        for (int slot = 0; slot < num_slots; ++slot) {
+                            FieldSumArrays slot_sum = slot_sums(slot);
+                            sum.u += slot_sum.u[i];
+                            sum.r += slot_sum.r[i];
+                            sum.grad_u_x += slot_sum.grad_u_x[i];
+                            sum.grad_u_y += slot_sum.grad_u_y[i];
+                            sum.grad_r_x += slot_sum.grad_r_x[i];
+                            sum.grad_r_y += slot_sum.grad_r_y[i];
+                        }
+                        sums[k] = sum;
+                    }
+                });
+    });
+}
+
+void ParticleLenia2DCpu::step_cell_list() {
+    const FieldParameters parameters = field_parameters();
+
+    // the central difference positions may lie up to h outside of the cell of their particle
+    cell_list.build(x.data(), y.data(), num_particles, cutoff_radius() + (analytic_gradient ? 0.0f : h));
+    sorted_x_updated.resize(num_particles);
+    sorted_y_updated.resize(num_particles);
+
+    // all particles of one cell share their neighbour ranges, so cells are the unit of work
+    pool->parallel_for(0, cell_list.num_cells(), std::max(1, chunk_size / 4), [&](int first_cell, int last_cell) {
+        std::vector<FieldSums> range_sums;
+        for (int cell = first_cell; cell < last_cell; ++cell) {
+            int begin = cell_list.cell_start[cell];
+            int count = cell_list.cell_start[cell + 1] - begin;
+            if (count == 0) continue;
+
+            std::array<std::pair<int, int>, 3> ranges;
+            int num_ranges = cell_list.neighbour_ranges(cell, ranges);
+
+            integrate(cell_list.x.data() + begin, cell_list.y.data() + begin, count,
+                      sorted_x_updated.data() + begin, sorted_y_updated.data() + begin,
+                      [&](const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+                          for (int q = 0; q < num_queries; ++q) sums[q] = FieldSums{0, 0, 0, 0, 0, 0};
+                          range_sums.resize(num_queries);
+                          for (int r = 0; r < num_ranges; ++r) {
+                              int range_begin = ranges[r].first;
+                              kernel(parameters, cell_list.x.data() + range_begin, cell_list.y.data() + range_begin,
+                                     ranges[r].second - range_begin, query_x, query_y, num_queries,
+                                     range_sums.data());
+                              for (int q = 0; q < num_queries; ++q) {
+                                  sums[q].u += range_sums[q].u;
+                                  sums[q].r += range_sums[q].r;
+                                  sums[q].grad_u_x += range_sums[q].grad_u_x;
+                                  sums[q].grad_u_y += range_sums[q].grad_u_y;
+                                  sums[q].grad_r_x += range_sums[q].grad_r_x;
+                                  sums[q].grad_r_y += range_sums[q].grad_r_y;
+                              }
+                          }
+                      });
+        }
+    });
+
+    // back to the original particle order
+    pool->parallel_for(0, num_particles, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            x_updated[cell_list.index[i]] = sorted_x_updated[i];
+            y_updated[cell_list.index[i]] = sorted_y_updated[i];
+        }
+    });
+}
+
+void ParticleLenia2DCpu::build_verlet_lists(float radius) {
+    cell_list.build(x.data(), y.data(), num_particles, radius);
+    const float radius2 = radius * radius;
+
+    // the lists are written in two passes, first counting the neighbours of every particle and then filling them in
+    verlet_start.assign(num_particles + 1, 0);
+    auto visit_neighbours = [&](int s, bool fill) {
+        std::array<std::pair<int, int>, 3> ranges;
+        int num_ranges = cell_list.neighbour_ranges(cell_list.cell_of(cell_list.x[s], cell_list.y[s]), ranges);
+        int count = 0;
+        for (int r = 0; r < num_ranges; ++r) {
+            for (int j = ranges[r].first; j < ranges[r].second; ++j) {
+                float dx = cell_list.x[j] - cell_list.x[s];
+                float dy = cell_list.y[j] - cell_list.y[s];
+                if (dx * dx + dy * dy > radius2) continue;
+                if (fill) verlet_neighbours[verlet_start[s] + count] = cell_list.index[j];
+                ++count;
+            }
+        }
+        return count;
+    };
+
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        for (int s = begin; s < end; ++s) verlet_start[s + 1] = visit_neighbours(s, false);
+    });
+    for (int s = 0; s < num_particles; ++s) verlet_start[s + 1] += verlet_start[s];
+    verlet_neighbours.resize(verlet_start[num_particles]);
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        for (int s = begin; s < end; ++s) visit_neighbours(s, true);
+    });
+
+    verlet_order = cell_list.index;
+    verlet_x = x;
+    verlet_y = y;
+    verlet_radius = radius;
+    verlet_displacement = 0;
+
+    ++verlet_statistics.rebuilds;
+    verlet_statistics.average_length = num_particles > 0 ? (float) verlet_neighbours.size() / num_particles : 0.0f;
+}
+
+void ParticleLenia2DCpu::step_verlet_list() {
+    const FieldParameters parameters = field_parameters();
+
+    // the central difference positions may lie up to h away from their particle
+    const float radius = cutoff_radius() + verlet_skin + (analytic_gradient ? 0.0f : h);
+    // two particles can have come closer by at most twice the largest displacement, as long as that is within the
+    // skin no particle is missing from the lists
+    if (radius != verlet_radius || (int) verlet_x.size() != num_particles || 2 * verlet_displacement > verlet_skin) {
+        build_verlet_lists(radius);
+    }
+    ++verlet_statistics.steps;
+
+    chunk_displacement2.assign((num_particles + chunk_size - 1) / chunk_size, 0.0f);
+
+    // particles are visited in cell order, so neighbouring particles of a chunk share most of their neighbours
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        int count = end - begin;
+        std::vector<float> particle_x(count), particle_y(count), updated_x(count), updated_y(count);
+        for (int k = 0; k < count; ++k) {
+            particle_x[k] = x[verlet_order[begin + k]];
+            particle_y[k] = y[verlet_order[begin + k]];
+        }
+
+        std::vector<float> neighbour_x, neighbour_y;
+        integrate(particle_x.data(), particle_y.data(), count, updated_x.data(), updated_y.data(),
+                  [&](const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+                      int queries_per_particle = num_queries / count;
+                      for (int k = 0; k < count; ++k) {
+                          int first = verlet_start[begin + k];
+                          int num_neighbours = verlet_start[begin + k + 1] - first;
+                          neighbour_x.resize(num_neighbours);
+                          neighbour_y.resize(num_neighbours);
+                          for (int n = 0; n < num_neighbours; ++n) {
+                              neighbour_x[n] = x[verlet_neighbours[first + n]];
+                              neighbour_y[n] = y[verlet_neighbours[first + n]];
+                          }
+                          int offset = k * queries_per_particle;
+                          kernel(parameters, neighbour_x.data(), neighbour_y.data(), num_neighbours,
+                                 query_x + offset, query_y + offset, queries_per_particle, sums + offset);
+                      }
+                  });
+
+        float displacement2 = 0.0f;
+        for (int k = 0; k < count; ++k) {
+            int i = verlet_order[begin + k];
+            x_updated[i] = updated_x[k];
+            y_updated[i] = updated_y[k];
+            float dx = updated_x[k] - verlet_x[i];
+            float dy = updated_y[k] - verlet_y[i];
+            displacement2 = std::max(displacement2, dx * dx + dy * dy);
+        }
+        chunk_displacement2[begin / chunk_size] = displacement2;
+    });
+
+    float displacement2 = 0.0f;
+    for (float chunk: chunk_displacement2) displacement2 = std::max(displacement2, chunk);
+    verlet_displacement = std::sqrt(displacement2);
+}
+
+void ParticleLenia2DCpu::step_barnes_hut() {
+    const FieldParameters parameters = field_parameters();
+
+    barnes_hut_tree.build({x.data(), y.data()}, num_particles);
+    // the repulsion only reaches 1, so cells of size 1 are enough for set_repulsion
+    cell_list.build(x.data(), y.data(), num_particles, 1.0f);
+    sorted_x_updated.resize(num_particles);
+    sorted_y_updated.resize(num_particles);
+
+    const std::vector<float> &tree_x = barnes_hut_tree.sorted_coordinates(0);
+    const std::vector<float> &tree_y = barnes_hut_tree.sorted_coordinates(1);
+
+    // particles are visited in cell order, so queries of one chunk take similar paths through the tree
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        std::vector<std::pair<int, int>> near;
+        FieldSums near_sums;
+        integrate(cell_list.x.data() + begin, cell_list.y.data() + begin, end - begin,
+                  sorted_x_updated.data() + begin, sorted_y_updated.data() + begin,
+                  [&](const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+                      for (int q = 0; q < num_queries; ++q) {
+                          float u = 0.0f;
+                          std::array<float, 2> grad_u{0.0f, 0.0f};
+                          barnes_hut_tree.add_far_field(parameters, barnes_hut_theta, {query_x[q], query_y[q]}, u,
+                                                        grad_u, near);
+                          // the repulsion of the near particles is ignored, it is summed up with the cell list below
+                          for (const std::pair<int, int> &range: near) {
+                              kernel(parameters, tree_x.data() + range.first, tree_y.data() + range.first,
+                                     range.second - range.first, query_x + q, query_y + q, 1, &near_sums);
+                              u += near_sums.u;
+                              grad_u[0] += near_sums.grad_u_x;
+                              grad_u[1] += near_sums.grad_u_y;
+                          }
+
+                          sums[q] = FieldSums{u, 0, grad_u[0], grad_u[1], 0, 0};
+                          set_repulsion(query_x[q], query_y[q], sums[q]);
+                      }
+                  });
+    });
+
+    // back to the original particle order
+    pool->parallel_for(0, num_particles, 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            x_updated[cell_list.index[i]] = sorted_x_updated[i];
+            y_updated[cell_list.index[i]] = sorted_y_updated[i];
+        }
+    });
+}
+
+void ParticleLenia2DCpu::step_particle_mesh() {
+    particle_mesh.mesh_size = mesh_size;
+    particle_mesh.build(field_parameters(), cutoff_radius(), x.data(), y.data(), num_particles, pool.get());
+    // the repulsion only reaches 1, so cells of size 1 are enough for set_repulsion
+    cell_list.build(x.data(), y.data(), num_particles, 1.0f);
+
+    pool->parallel_for(0, num_particles, chunk_size, [&](int begin, int end) {
+        integrate(x.data() + begin, y.data() + begin, end - begin, x_updated.data() + begin, y_updated.data() + begin,
+                  [&](const float *query_x, const float *query_y, int num_queries, FieldSums *sums) {
+                      for (int q = 0; q < num_queries; ++q) {
+                          sums[q] = particle_mesh.sample(query_x[q], query_y[q]);
+                          set_repulsion(query_x[q], query_y[q], sums[q]);
+                      }
+                  });
+    });
+}
+
+void ParticleLenia2DCpu::set_repulsion(float position_x, float position_y, FieldSums &sums) const {
+    std::array<std::pair<int, int>, 3> ranges;
+    int num_ranges = cell_list.neighbour_ranges(cell_list.cell_of(position_x, position_y), ranges);
+    float r = 0.0f, grad_r_x = 0.0f, grad_r_y = 0.0f;
+    for (int n = 0; n < num_ranges; ++n) {
+        for (int j = ranges[n].first; j < ranges[n].second; ++j) {
+            float dx = position_x - cell_list.x[j];
+            float dy = position_y - cell_list.y[j];
+            float norm = std::sqrt(dx * dx + dy * dy);
+            if (norm < r_distance || norm >= 1.0f) continue;
+            float overlap = 1.0f - norm;
+            r += overlap * overlap;
+            grad_r_x += -2.0f * overlap / norm * dx;
+            grad_r_y += -2.0f * overlap / norm * dy;
+        }
+    }
+    sums.r = r;
+    sums.grad_r_x = grad_r_x;
+    sums.grad_r_y = grad_r_y;
+}
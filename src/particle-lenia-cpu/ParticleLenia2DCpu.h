@@ -0,0 +1,190 @@
+#ifndef PARTICLE_LENIA_PARTICLELENIA2DCPU_H
+#define PARTICLE_LENIA_PARTICLELENIA2DCPU_H
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BarnesHutTree.h"
+#include "CellList.h"
+#include "FieldKernel.h"
+#include "ParticleLeniaCore.h"
+#include "ParticleMesh.h"
+#include "ThreadPool.h"
+
+// how step finds the particles that contribute to the fields at a position
+enum class NeighbourSearch {
+    // every particle contributes, exact
+    ALL_PAIRS,
+    // like ALL_PAIRS, but every unordered pair is evaluated once and added to both particles, which halves the
+    // kernel evaluations. Reproducible for a fixed number of threads, needs analytic_gradient (falls back to ALL_PAIRS)
+    SYMMETRIC_PAIRS,
+    // only particles within cutoff_radius() contribute, found with a uniform grid rebuilt every step
+    CELL_LIST,
+    // only particles within cutoff_radius() contribute, found with per particle neighbour lists of radius
+    // cutoff_radius() + verlet_skin that are reused until a particle has moved further than verlet_skin / 2
+    VERLET_LIST,
+    // U is approximated with a Barnes-Hut quadtree (see barnes_hut_theta), the repulsion is exact
+    BARNES_HUT,
+    // U is convolved on a mesh of mesh_size^2 points with FFTs (see ParticleMesh), the repulsion is exact
+    PARTICLE_MESH
+};
+
+// counters of the verlet lists
+struct VerletListStatistics {
+    // steps taken with verlet lists
+    long steps;
+    // number of times the lists were built
+    long rebuilds;
+    // average number of neighbours per particle in the lists of the last build
+    float average_length;
+};
+
+/**
+ * Headless reference implementation of the 2D particle lenia simulation.
+ * Evaluates the fields exactly like shaders/particle-lenia/fields_functions.glsl and steps the particles like
+ * shaders/particle-lenia/particle.comp, but in plain C++ without any OpenGL context.
+ */
+class ParticleLenia2DCpu : public ParticleLeniaCore<2, float> {
+public:
+    // the field functions below take the particles of the simulation, the ones of the core take them as arguments
+    using ParticleLeniaCore<2, float>::U_and_R;
+    using ParticleLeniaCore<2, float>::fields;
+    using ParticleLeniaCore<2, float>::gradient;
+    using ParticleLeniaCore<2, float>::analytic_gradient_of;
+
+    NeighbourSearch neighbour_search = NeighbourSearch::ALL_PAIRS;
+    // distance added to the radius of the verlet lists, larger skins need fewer rebuilds but make the lists longer
+    float verlet_skin = 1.0;
+    VerletListStatistics verlet_statistics{0, 0, 0.0f};
+    // opening angle of the Barnes-Hut tree, 0 is exact, larger values approximate more of U
+    float barnes_hut_theta = 0.5;
+    // mesh points per axis of the particle mesh, rounded up to the next power of two
+    int mesh_size = 256;
+
+    // number of particles updated by one task of the thread pool, small enough to balance clustered particles
+    int chunk_size = 64;
+
+    // particle positions, stored as separate x and y arrays (SoA) so the field kernels can load them as vectors
+    std::vector<float> x;
+    std::vector<float> y;
+
+    /**
+     * @param num_threads number of threads used to step the particles, values < 1 use all hardware threads
+     */
+    explicit ParticleLenia2DCpu(int num_threads = 0);
+
+    /**
+     * Replaces the thread pool used by step.
+     * @param num_threads number of threads, values < 1 use all hardware threads
+     */
+    void set_num_threads(int num_threads);
+
+    int get_num_threads() const;
+
+    /**
+     * Selects the all-pairs kernel used by step, paths the host cpu doesn't support fall back to the best one
+     * that it does. The chosen path is logged.
+     */
+    void set_kernel_path(FieldKernelPath path);
+
+    FieldKernelPath get_kernel_path() const;
+
+    /**
+     * Places num_particles particles uniformly at random in [-0.3 * width, 0.3 * width]^2.
+     * @param width internal width of the simulated area
+     * @param seed seed for the random number generator, fixed seeds give reproducible runs
+     */
+    void reset_particles(float width, unsigned int seed);
+
+    /**
+     * Replaces all particles, num_particles is updated accordingly.
+     * @param data interleaved x, y pairs
+     */
+    void set_particles(const std::vector<float> &data);
+
+    // returns the particles as interleaved x, y pairs, same layout as the particle buffers on the gpu
+    std::vector<float> get_particles() const;
+
+    // calculates the value of the field U and the repulsion field R at the given position
+    std::array<float, 2> U_and_R(float position_x, float position_y) const;
+
+    // calculates the values of all fields in the following order: u, r, g, e
+    std::array<float, 4> fields(float position_x, float position_y) const;
+
+    // calculates the gradient of the energy field at the given position using central differences
+    std::array<float, 2> gradient(float position_x, float position_y) const;
+
+    // calculates the gradient of the energy field at the given position analytically
+    std::array<float, 2> analytic_gradient_of(float position_x, float position_y) const;
+
+    /**
+     * Advances the simulation.
+     * @param steps number of time steps to take
+     */
+    void step(int steps);
+
+private:
+    /**
+     * Calculates the updated positions of count particles.
+     * @param sums_at called as sums_at(query_x, query_y, num_queries, sums), has to fill in the field sums at the
+     * query positions, which are the particle positions or their central difference offsets
+     */
+    template<typename SumsAt>
+    void integrate(const float *particle_x, const float *particle_y, int count, float *updated_x, float *updated_y,
+                   SumsAt sums_at) const;
+
+    void step_all_pairs();
+
+    void step_symmetric_pairs();
+
+    void step_cell_list();
+
+    // builds the verlet lists of all particles within radius, the particles are ordered by their cell
+    void build_verlet_lists(float radius);
+
+    void step_verlet_list();
+
+    void step_barnes_hut();
+
+    void step_particle_mesh();
+
+    // sets the repulsion and its gradient at a position, cell_list has to be built with a cell size of at least 1
+    void set_repulsion(float position_x, float position_y, FieldSums &sums) const;
+
+    // one set of sums per thread for the symmetric pairs, slot after slot with 6 arrays of num_particles floats each
+    std::vector<float> pair_sums;
+
+    CellList cell_list;
+    std::vector<float> sorted_x_updated;
+    std::vector<float> sorted_y_updated;
+
+    // particles in the order of their cells at the last build
+    std::vector<int> verlet_order;
+    // neighbours (original indices) of particle verlet_order[s] are [verlet_start[s], verlet_start[s + 1])
+    std::vector<int> verlet_start;
+    std::vector<int> verlet_neighbours;
+    // radius of the current lists, 0 forces a rebuild
+    float verlet_radius = 0;
+    // positions at the last build and the largest distance any particle has moved since then
+    std::vector<float> verlet_x;
+    std::vector<float> verlet_y;
+    float verlet_displacement = 0;
+    // largest squared displacement per chunk of the last step
+    std::vector<float> chunk_displacement2;
+
+    BarnesHutTree<2> barnes_hut_tree;
+    ParticleMesh particle_mesh;
+
+    std::vector<float> x_updated;
+    std::vector<float> y_updated;
+    FieldKernelPath kernel_path;
+    FieldKernel kernel;
+    PairKernel pair_kernel;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+
+#endif //PARTICLE_LENIA_PARTICLELENIA2DCPU_H
@@ -0,0 +1,243 @@
+#ifndef PARTICLE_LENIA_PARTICLELENIACORE_H
+#define PARTICLE_LENIA_PARTICLELENIACORE_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FieldKernel.h"
+
+/**
+ * Parameters and reference kernels of particle lenia in Dim (2 or 3) dimensions, shared by the 2D and the 3D version
+ * on the gpu (ParticleLenia2D, ParticleLenia3D) and the cpu implementation (ParticleLenia2DCpu), which derive from it.
+ * The loops over the dimensions have a compile time trip count and are unrolled, so the kernels are written once
+ * and still compile to straight code for both dimensions. Scalar is float for the simulations, double gives a
+ * reference to check them against. The shaders always use float.
+ *
+ * Particles are passed as one Vector each. The gpu buffers hold STRIDE floats per particle, pack() and unpack()
+ * convert between the two, and glsl_prefix() defines the matching vector types for the shaders.
+ */
+template<int Dim, typename Scalar>
+class ParticleLeniaCore {
+    static_assert(Dim == 2 || Dim == 3, "particle lenia is implemented for 2 and 3 dimensions");
+
+public:
+    typedef std::array<Scalar, Dim> Vector;
+
+    static const int DIMENSION = Dim;
+    // floats per particle in the gpu buffers, std430 pads the elements of vec3 arrays to 16 bytes
+    static const int STRIDE = Dim == 3 ? 4 : Dim;
+
+    // parameters for the kernel
+    Scalar w_k = 0.022;
+    Scalar mu_k = 4.0;
+    // sigma k squared
+    Scalar sigma_k2 = 1.0;
+
+    // parameters for the growth field
+    Scalar mu_g = 0.6;
+    // sigma g squared
+    Scalar sigma_g2 = std::pow(Scalar(0.15), Scalar(2));
+
+    // factor used to scale repulsion
+    Scalar c_rep = 1.0;
+    // minimum distance to particle for repulsion
+    Scalar r_distance = 1e-10;
+
+    // number of particles
+    int num_particles = 300;
+
+    // value for gradient calculations
+    Scalar h = 0.01;
+    Scalar h2 = 2 * h;
+    // time step size
+    Scalar dt = 0.1;
+    // evaluate the energy gradient analytically in one pass instead of using central differences (uses h)
+    bool analytic_gradient = true;
+
+    // maximum value of K that may be neglected per particle when only near particles are summed up,
+    // determines cutoff_radius()
+    Scalar cutoff_tolerance = 1e-6;
+
+    // applies the kernel function to a value r
+    Scalar K(Scalar r) const {
+        return w_k * std::exp(-(r - mu_k) * (r - mu_k) / sigma_k2);
+    }
+
+    // derivative of the kernel function K with respect to r
+    Scalar K_derivative(Scalar r) const {
+        return -2 * (r - mu_k) / sigma_k2 * K(r);
+    }
+
+    // calculates the value of the growth field G based on the field U
+    Scalar G(Scalar u) const {
+        return std::exp(-(u - mu_g) * (u - mu_g) / sigma_g2);
+    }
+
+    // derivative of the growth field G with respect to u
+    Scalar G_derivative(Scalar u) const {
+        return -2 * (u - mu_g) / sigma_g2 * G(u);
+    }
+
+    // calculates the value of the energy field based on the value of the repulsion and the growth field
+    Scalar E(Scalar r, Scalar g) const {
+        return r - g;
+    }
+
+    /**
+     * Distance beyond which K(r) <= cutoff_tolerance, but at least 1 (the range of the repulsion).
+     * Solves w_k * exp(-(r - mu_k)^2 / sigma_k^2) = tolerance for r > mu_k, a tolerance of 0 returns mu_k.
+     */
+    Scalar cutoff_radius() const {
+        Scalar radius = mu_k;
+        if (w_k > cutoff_tolerance && cutoff_tolerance > 0) {
+            radius += std::sqrt(sigma_k2 * std::log(w_k / cutoff_tolerance));
+        }
+        return std::max(radius, Scalar(1));
+    }
+
+    // parameters of K and the repulsion for the float field kernels
+    FieldParameters field_parameters() const {
+        return FieldParameters{(float) w_k, (float) mu_k, (float) sigma_k2, (float) r_distance};
+    }
+
+    // calculates the euclidean norm of a vector
+    static Scalar euclid_norm(const Vector &vector) {
+        Scalar sum = 0;
+        for (int d = 0; d < Dim; ++d) sum += vector[d] * vector[d];
+        return std::sqrt(sum);
+    }
+
+    // calculates the value of the field U and the repulsion field R at the given position
+    std::array<Scalar, 2> U_and_R(const std::vector<Vector> &particles, const Vector &position) const {
+        Scalar u = 0;
+        Scalar r = 0;
+        for (const Vector &particle : particles) {
+            Vector difference;
+            for (int d = 0; d < Dim; ++d) difference[d] = particle[d] - position[d];
+            Scalar norm = euclid_norm(difference);
+            u += K(norm);
+            if (norm >= r_distance) {
+                Scalar overlap = std::max(1 - norm, Scalar(0));
+                r += overlap * overlap;
+            }
+        }
+        return {u, r};
+    }
+
+    // calculates the values of all fields in the following order: u, r, g, e
+    std::array<Scalar, 4> fields(const std::vector<Vector> &particles, const Vector &position) const {
+        std::array<Scalar, 2> ur = U_and_R(particles, position);
+        Scalar g = G(ur[0]);
+        Scalar e = E(ur[1], g);
+        return {ur[0], ur[1], g, e};
+    }
+
+    // calculates the gradient of the energy field at the given position using central differences
+    Vector gradient(const std::vector<Vector> &particles, const Vector &position) const {
+        Vector gradient;
+        for (int d = 0; d < Dim; ++d) {
+            Vector forward = position;
+            Vector backward = position;
+            forward[d] += h;
+            backward[d] -= h;
+            gradient[d] = (fields(particles, forward)[3] - fields(particles, backward)[3]) / h2;
+        }
+        return gradient;
+    }
+
+    /**
+     * Calculates the gradient of the energy field at the given position analytically, in one pass over the particles
+     * grad U(position) = sum_i K'(||position - particle_i||) * (position - particle_i) / ||position - particle_i||
+     * grad R(position) = sum_i -2 * max(1 - ||position - particle_i||, 0) * (position - particle_i) / ||...||
+     * grad E = grad R - G'(U) * grad U
+     */
+    Vector analytic_gradient_of(const std::vector<Vector> &particles, const Vector &position) const {
+        Scalar u = 0;
+        Vector grad_u{};
+        Vector grad_r{};
+        for (const Vector &particle : particles) {
+            Vector difference;
+            for (int d = 0; d < Dim; ++d) difference[d] = position[d] - particle[d];
+            Scalar norm = euclid_norm(difference);
+            u += K(norm);
+            // the direction is undefined for particles directly at the position, their contribution is zero
+            if (norm >= r_distance) {
+                Scalar k = K_derivative(norm) / norm;
+                Scalar rep = -2 * std::max(1 - norm, Scalar(0)) / norm;
+                for (int d = 0; d < Dim; ++d) {
+                    grad_u[d] += k * difference[d];
+                    grad_r[d] += rep * difference[d];
+                }
+            }
+        }
+        Scalar g = G_derivative(u);
+        Vector gradient;
+        for (int d = 0; d < Dim; ++d) gradient[d] = grad_r[d] - g * grad_u[d];
+        return gradient;
+    }
+
+    // gradient of the energy field like the step shaders evaluate it, depending on analytic_gradient
+    Vector energy_gradient(const std::vector<Vector> &particles, const Vector &position) const {
+        return analytic_gradient ? analytic_gradient_of(particles, position) : gradient(particles, position);
+    }
+
+    // moves every particle one time step down the energy gradient, all pairs like the step shaders without the grid
+    std::vector<Vector> step_particles(const std::vector<Vector> &particles) const {
+        std::vector<Vector> updated(particles.size());
+        for (size_t i = 0; i < particles.size(); ++i) {
+            Vector gradient = energy_gradient(particles, particles[i]);
+            for (int d = 0; d < Dim; ++d) updated[i][d] = particles[i][d] - dt * gradient[d];
+        }
+        return updated;
+    }
+
+    // count particles placed uniformly at random in [-extent, extent]^Dim
+    static std::vector<Vector> random_particles(int count, double extent, std::mt19937 &rng) {
+        std::uniform_real_distribution<> distribution(-extent, extent);
+        std::vector<Vector> particles(count);
+        for (Vector &particle : particles) {
+            for (int d = 0; d < Dim; ++d) particle[d] = (Scalar) distribution(rng);
+        }
+        return particles;
+    }
+
+    // spreads the particles out to the layout of the gpu buffers, the spare lanes are 0
+    static std::vector<float> pack(const std::vector<Vector> &particles) {
+        std::vector<float> data(STRIDE * particles.size(), 0.0f);
+        for (size_t i = 0; i < particles.size(); ++i) {
+            for (int d = 0; d < Dim; ++d) data[STRIDE * i + d] = (float) particles[i][d];
+        }
+        return data;
+    }
+
+    // the first num_particles particles of data in the layout of the gpu buffers
+    static std::vector<Vector> unpack(const std::vector<float> &data, int num_particles) {
+        std::vector<Vector> particles(num_particles);
+        for (int i = 0; i < num_particles; ++i) {
+            for (int d = 0; d < Dim; ++d) particles[i][d] = (Scalar) data[STRIDE * i + d];
+        }
+        return particles;
+    }
+
+    /**
+     * Code that has to be put after the version line of the shaders of this dimension. It defines DIMENSION and the
+     * vector types vecN and ivecN, which the shared shader code (fields_functions.glsl, particle.comp and the grid)
+     * is written against.
+     */
+    static std::string glsl_prefix() {
+        std::string n = std::to_string(Dim);
+        return "#define DIMENSION " + n + "\n#define vecN vec" + n + "\n#define ivecN ivec" + n + "\n";
+    }
+};
+
+template<int Dim, typename Scalar>
+const int ParticleLeniaCore<Dim, Scalar>::DIMENSION;
+
+template<int Dim, typename Scalar>
+const int ParticleLeniaCore<Dim, Scalar>::STRIDE;
+
+#endif //PARTICLE_LENIA_PARTICLELENIACORE_H
@@ -0,0 +1,151 @@
+#include "ParticleMesh.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ParticleMesh::build(const FieldParameters &parameters, float cutoff, const float *xs, const float *ys,
+                         int num_particles, ThreadPool *pool) {
+    // the radix-2 fft and the periodic wrap of the deposit only work for powers of two
+    int power_of_two = 2;
+    while (power_of_two < mesh_size) power_of_two *= 2;
+    mesh_size = power_of_two;
+
+    float min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+    if (num_particles > 0) {
+        min_x = *std::min_element(xs, xs + num_particles);
+        max_x = *std::max_element(xs, xs + num_particles);
+        min_y = *std::min_element(ys, ys + num_particles);
+        max_y = *std::max_element(ys, ys + num_particles);
+    }
+
+    // positions within cutoff of a particle must not see the periodic image of any other particle
+    const float extent = std::max(max_x - min_x, max_y - min_y) + 2 * cutoff;
+    const float mesh_extent = spacing * (float) mesh_size;
+    bool parameters_changed = parameters.w_k != kernel_parameters.w_k || parameters.mu_k != kernel_parameters.mu_k ||
+                              parameters.sigma_k2 != kernel_parameters.sigma_k2 ||
+                              parameters.r_distance != kernel_parameters.r_distance || cutoff != kernel_cutoff;
+    if (!fft || fft->size() != mesh_size || parameters_changed || extent > mesh_extent || 2 * extent < mesh_extent) {
+        // some room, so particles that drift apart don't cause an update every step
+        spacing = 1.25f * extent / (float) mesh_size;
+        update_kernels(parameters, cutoff, pool);
+    }
+    origin_x = min_x - cutoff;
+    origin_y = min_y - cutoff;
+
+    // cloud-in-cell deposit, every particle is shared between the 4 surrounding mesh points
+    const int size = mesh_size;
+    density.assign(size * size, std::complex<float>(0.0f, 0.0f));
+    for (int i = 0; i < num_particles; ++i) {
+        float grid_x = (xs[i] - origin_x) / spacing;
+        float grid_y = (ys[i] - origin_y) / spacing;
+        int cell_x = (int) grid_x;
+        int cell_y = (int) grid_y;
+        float fraction_x = grid_x - (float) cell_x;
+        float fraction_y = grid_y - (float) cell_y;
+        int next_x = (cell_x + 1) & (size - 1);
+        int next_y = (cell_y + 1) & (size - 1);
+        density[cell_y * size + cell_x] += (1 - fraction_x) * (1 - fraction_y);
+        density[cell_y * size + next_x] += fraction_x * (1 - fraction_y);
+        density[next_y * size + cell_x] += (1 - fraction_x) * fraction_y;
+        density[next_y * size + next_x] += fraction_x * fraction_y;
+    }
+
+    transform(density, false, pool);
+    u_r.resize(size * size);
+    gradient.resize(size * size);
+    for (int i = 0; i < size * size; ++i) {
+        u_r[i] = density[i] * u_r_spectrum[i];
+        gradient[i] = density[i] * gradient_spectrum[i];
+    }
+    transform(u_r, true, pool);
+    transform(gradient, true, pool);
+
+    const float normalization = 1.0f / (float) (size * size);
+    fields.resize(4 * size * size);
+    for (int i = 0; i < size * size; ++i) {
+        fields[4 * i] = u_r[i].real() * normalization;
+        fields[4 * i + 1] = gradient[i].real() * normalization;
+        fields[4 * i + 2] = gradient[i].imag() * normalization;
+        fields[4 * i + 3] = u_r[i].imag() * normalization;
+    }
+}
+
+FieldSums ParticleMesh::sample(float position_x, float position_y) const {
+    float grid_x = (position_x - origin_x) / spacing;
+    float grid_y = (position_y - origin_y) / spacing;
+    // everything outside of the mesh is further than cutoff away from all particles
+    if (fields.empty() || !(grid_x >= 0 && grid_y >= 0 && grid_x < mesh_size - 1 && grid_y < mesh_size - 1)) {
+        return FieldSums{0, 0, 0, 0, 0, 0};
+    }
+
+    int cell_x = (int) grid_x;
+    int cell_y = (int) grid_y;
+    float fraction_x = grid_x - (float) cell_x;
+    float fraction_y = grid_y - (float) cell_y;
+    const float *corner = &fields[4 * (cell_y * mesh_size + cell_x)];
+    const float *above = corner + 4 * mesh_size;
+    float value[4];
+    for (int c = 0; c < 4; ++c) {
+        value[c] = (1 - fraction_y) * ((1 - fraction_x) * corner[c] + fraction_x * corner[4 + c]) +
+                   fraction_y * ((1 - fraction_x) * above[c] + fraction_x * above[4 + c]);
+    }
+    return FieldSums{value[0], value[3], value[1], value[2], 0, 0};
+}
+
+const std::vector<float> &ParticleMesh::mesh_fields() const {
+    return fields;
+}
+
+void ParticleMesh::update_kernels(const FieldParameters &parameters, float cutoff, ThreadPool *pool) {
+    const int size = mesh_size;
+    if (!fft || fft->size() != size) fft.reset(new Fft(size));
+    kernel_parameters = parameters;
+    kernel_cutoff = cutoff;
+    ++kernel_updates;
+
+    // the kernels are sampled at the offsets between mesh points, negative offsets wrap around to the end
+    u_r_spectrum.resize(size * size);
+    gradient_spectrum.resize(size * size);
+    for (int j = 0; j < size; ++j) {
+        float dy = (float) (j < size / 2 ? j : j - size) * spacing;
+        for (int i = 0; i < size; ++i) {
+            float dx = (float) (i < size / 2 ? i : i - size) * spacing;
+            float norm = std::sqrt(dx * dx + dy * dy);
+            float t = norm - parameters.mu_k;
+            float k = norm <= cutoff ? parameters.w_k * std::exp(-t * t / parameters.sigma_k2) : 0.0f;
+            float repulsion = 0.0f, k_x = 0.0f, k_y = 0.0f;
+            // the direction is undefined for particles directly at the position, their contribution is zero
+            if (norm >= parameters.r_distance) {
+                float overlap = std::max(1.0f - norm, 0.0f);
+                float k_derivative = -2.0f * t / parameters.sigma_k2 * k / norm;
+                repulsion = overlap * overlap;
+                k_x = k_derivative * dx;
+                k_y = k_derivative * dy;
+            }
+            u_r_spectrum[j * size + i] = std::complex<float>(k, repulsion);
+            gradient_spectrum[j * size + i] = std::complex<float>(k_x, k_y);
+        }
+    }
+    transform(u_r_spectrum, false, pool);
+    transform(gradient_spectrum, false, pool);
+}
+
+void ParticleMesh::transform(std::vector<std::complex<float>> &values, bool inverse, ThreadPool *pool) const {
+    const int size = mesh_size;
+    auto for_rows = [&](const std::function<void(int, int)> &function) {
+        if (pool) pool->parallel_for(0, size, 16, function);
+        else function(0, size);
+    };
+
+    for_rows([&](int begin, int end) {
+        for (int row = begin; row < end; ++row) fft->transform(values.data() + row * size, inverse);
+    });
+    for_rows([&](int begin, int end) {
+        std::vector<std::complex<float>> column(size);
+        for (int x = begin; x < end; ++x) {
+            for (int y = 0; y < size; ++y) column[y] = values[y * size + x];
+            fft->transform(column.data(), inverse);
+            for (int y = 0; y < size; ++y) values[y * size + x] = column[y];
+        }
+    });
+}
@@ -0,0 +1,70 @@
+#ifndef PARTICLE_LENIA_PARTICLEMESH_H
+#define PARTICLE_LENIA_PARTICLEMESH_H
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+#include "FieldKernel.h"
+#include "Fft.h"
+#include "ThreadPool.h"
+
+/**
+ * Particle-mesh evaluation of the fields: U is the convolution of the particle density with K, so the particles are
+ * deposited onto a periodic mesh with cloud-in-cell weights and convolved with K, grad K and the repulsion by
+ * multiplying with their precomputed spectra. The fields at any position are then interpolated from the mesh with
+ * the same bilinear weights. Costs O(N + M log M) for M mesh points instead of O(N^2).
+ */
+class ParticleMesh {
+public:
+    // number of mesh points along each axis, build() rounds it up to the next power of two
+    int mesh_size = 256;
+
+    // position of mesh point (0, 0) and distance between neighbouring mesh points
+    float origin_x = 0;
+    float origin_y = 0;
+    float spacing = 1;
+
+    // number of times the spectra of the kernels had to be recomputed
+    long kernel_updates = 0;
+
+    /**
+     * Deposits the particles and convolves them. The spectra of the kernels are reused as long as the parameters stay
+     * the same and the particles still fit onto the mesh without losing more than half of the resolution.
+     * @param cutoff K is treated as 0 beyond this distance, the mesh covers the particles plus cutoff on every side, so
+     * the periodic convolution doesn't wrap around
+     * @param pool transforms rows and columns in parallel, may be nullptr
+     */
+    void build(const FieldParameters &parameters, float cutoff, const float *xs, const float *ys, int num_particles,
+               ThreadPool *pool);
+
+    // interpolates U, grad U and R at a position, grad R is left 0 (it is only needed at the particles)
+    FieldSums sample(float position_x, float position_y) const;
+
+    // fields at the mesh points, row by row with 4 floats per point: U, dU/dx, dU/dy, R
+    const std::vector<float> &mesh_fields() const;
+
+private:
+    // samples the kernels on the mesh and transforms them, sets spacing
+    void update_kernels(const FieldParameters &parameters, float cutoff, ThreadPool *pool);
+
+    // 2D transform of a mesh, rows first, then columns
+    void transform(std::vector<std::complex<float>> &values, bool inverse, ThreadPool *pool) const;
+
+    std::unique_ptr<Fft> fft;
+    // spectra of K + i * repulsion and of dK/dx + i * dK/dy, so one inverse transform yields two real fields
+    std::vector<std::complex<float>> u_r_spectrum;
+    std::vector<std::complex<float>> gradient_spectrum;
+
+    // what the spectra were computed for
+    FieldParameters kernel_parameters{0, 0, 0, 0};
+    float kernel_cutoff = 0;
+
+    std::vector<std::complex<float>> density;
+    std::vector<std::complex<float>> u_r;
+    std::vector<std::complex<float>> gradient;
+    std::vector<float> fields;
+};
+
+
+#endif //PARTICLE_LENIA_PARTICLEMESH_H
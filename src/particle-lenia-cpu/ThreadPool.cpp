@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int num_threads) {
+    if (num_threads < 1) num_threads = (int) std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < num_threads; ++i) queues.emplace_back(new Queue());
+    for (int i = 1; i < num_threads; ++i) threads.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake_up.notify_all();
+    for (std::thread &thread: threads) thread.join();
+}
+
+int ThreadPool::size() const {
+    return (int) queues.size();
+}
+
+void ThreadPool::parallel_for(int begin, int end, int chunk_size,
+                              const std::function<void(int, int)> &function) {
+    if (begin >= end) return;
+    chunk_size = std::max(chunk_size, 1);
+
+    // without other workers there is nothing to distribute
+    if (threads.empty()) {
+        for (int i = begin; i < end; i += chunk_size) function(i, std::min(i + chunk_size, end));
+        return;
+    }
+
+    int num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &function;
+        remaining = num_chunks;
+        // chunks are dealt round robin, so every worker starts on a different part of the range
+        for (int c = 0; c < num_chunks; ++c) {
+            int chunk_begin = begin + c * chunk_size;
+            Queue &queue = *queues[c % queues.size()];
+            std::lock_guard<std::mutex> queue_lock(queue.mutex);
+            queue.chunks.emplace_back(chunk_begin, std::min(chunk_begin + chunk_size, end));
+        }
+        ++generation;
+    }
+    wake_up.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::worker_loop(int index) {
+    unsigned long seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake_up.wait(lock, [&] { return stop || generation != seen_generation; });
+            if (stop) return;
+            seen_generation = generation;
+        }
+        run_chunks(index);
+    }
+}
+
+void ThreadPool::run_chunks(int index) {
+    std::pair<int, int> chunk;
+    while (pop_own(index, chunk) || steal(index, chunk)) {
+        (*job)(chunk.first, chunk.second);
+        if (--remaining == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::pop_own(int index, std::pair<int, int> &chunk) {
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty()) return false;
+    chunk = queue.chunks.front();
+    queue.chunks.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(int index, std::pair<int, int> &chunk) {
+    int num_queues = (int) queues.size();
+    for (int offset = 1; offset < num_queues; ++offset) {
+        Queue &queue = *queues[(index + offset) % num_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.chunks.empty()) continue;
+        chunk = queue.chunks.back();
+        queue.chunks.pop_back();
+        return true;
+    }
+    return false;
+}
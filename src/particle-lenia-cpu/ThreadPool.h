@@ -0,0 +1,73 @@
+#ifndef PARTICLE_LENIA_THREADPOOL_H
+#define PARTICLE_LENIA_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed size thread pool with work stealing.
+ * A parallel_for splits its range into chunks that are distributed round robin over one queue per worker.
+ * Workers take chunks from the front of their own queue and, once it is empty, steal from the back of the
+ * queues of the other workers, so uneven work per chunk (e.g. dense clusters of particles) is balanced out.
+ */
+class ThreadPool {
+public:
+    /**
+     * Creates the pool, the calling thread of parallel_for takes part in the work as worker 0.
+     * @param num_threads total number of workers, values < 1 use std::thread::hardware_concurrency()
+     */
+    explicit ThreadPool(int num_threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // number of workers including the calling thread
+    int size() const;
+
+    /**
+     * Calls function(chunk_begin, chunk_end) for consecutive chunks of [begin, end) on all workers and
+     * blocks until every chunk has been processed.
+     * @param chunk_size maximum number of elements per chunk
+     */
+    void parallel_for(int begin, int end, int chunk_size, const std::function<void(int, int)> &function);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::pair<int, int>> chunks;
+    };
+
+    void worker_loop(int index);
+
+    // processes chunks until no queue has any left
+    void run_chunks(int index);
+
+    bool pop_own(int index, std::pair<int, int> &chunk);
+
+    bool steal(int index, std::pair<int, int> &chunk);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    const std::function<void(int, int)> *job = nullptr;
+    std::atomic<int> remaining{0};
+
+    std::mutex mutex;
+    std::condition_variable wake_up;
+    std::condition_variable done;
+    unsigned long generation = 0;
+    bool stop = false;
+};
+
+
+#endif //PARTICLE_LENIA_THREADPOOL_H
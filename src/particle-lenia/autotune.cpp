@@ -0,0 +1,93 @@
+#include <imgui/imgui.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "particle_lenia_2d.hpp"
+#include "tuning_profile.hpp"
+
+// measures the 2D step for several workgroup sizes, tile sizes and neighbour searches on the current device and
+// writes the fastest configuration to TUNING_PROFILE_PATH, which gui2d and gui3d load at startup
+// usage: autotune [num_particles] [steps]
+int num_particles = 10000;
+int steps = 20;
+
+ParticleLenia2D particle_lenia;
+
+bool render_loop_call(GLFWwindow *window);
+
+void call_after_glfw_init(GLFWwindow *window);
+
+int main(int argc, char **argv) {
+    if (argc > 1) num_particles = std::atoi(argv[1]);
+    if (argc > 2) steps = std::max(std::atoi(argv[2]), 1);
+    init<render_loop_call, call_after_glfw_init>(100, 100, "Particle Lenia Autotune");
+}
+
+bool render_loop_call(GLFWwindow *window) {
+    // everything happens in call_after_glfw_init
+    return false;
+}
+
+// seconds per step of the current configuration, always starting from the same particles
+double seconds_per_step(const std::vector<float> &initial) {
+    particle_lenia.particles_a.set_data(initial);
+    particle_lenia.particles_b.set_data(initial);
+    particle_lenia.is_particles_a = true;
+    // the first dispatch of a new shader includes driver work that doesn't belong to the measurement
+    particle_lenia.step(1);
+    glFinish();
+
+    auto start = std::chrono::steady_clock::now();
+    particle_lenia.step(steps);
+    glFinish();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / steps;
+}
+
+void call_after_glfw_init(GLFWwindow *window) {
+    int max_invocations, max_size_x, max_shared_memory;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &max_size_x);
+    glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &max_shared_memory);
+
+    // tiles only matter without the grid, with the grid every invocation loops over its own cells
+    std::vector<TuningProfile> candidates;
+    for (int local_size = 32; local_size <= std::min(max_invocations, max_size_x); local_size *= 2) {
+        for (int tile_size = local_size; tile_size <= 8 * local_size; tile_size *= 2) {
+            if (tile_size * 2 * (int) sizeof(float) > max_shared_memory) break;
+            candidates.push_back(TuningProfile{local_size, tile_size, false, num_particles});
+        }
+        candidates.push_back(TuningProfile{local_size, local_size, true, num_particles});
+    }
+
+    particle_lenia.num_particles = num_particles;
+    // keep the density of the default 300 particles in a 30 x 30 area
+    particle_lenia.internal_width = 30 * std::sqrt(std::max(num_particles, 300) / 300.0f);
+    particle_lenia.internal_height = particle_lenia.internal_width;
+    particle_lenia.init();
+    particle_lenia.resize_buffer(true);
+    const std::vector<float> initial = particle_lenia.particles_a.get_data();
+
+    std::printf("%s\n%d particles, %d steps per measurement\n", tuning_device_key().c_str(), num_particles, steps);
+    std::printf("%10s %10s %10s %12s\n", "local size", "tile size", "search", "ms per step");
+    TuningProfile best;
+    double best_seconds = -1;
+    for (const TuningProfile &candidate: candidates) {
+        particle_lenia.local_size = candidate.local_size;
+        particle_lenia.tile_size = candidate.tile_size;
+        particle_lenia.use_grid = candidate.use_grid;
+        particle_lenia.compile_step_shader();
+
+        double seconds = seconds_per_step(initial);
+        std::printf("%10d %10d %10s %12.3f\n", candidate.local_size, candidate.tile_size,
+                    candidate.use_grid ? "grid" : "all pairs", 1000 * seconds);
+        if (best_seconds < 0 || seconds < best_seconds) {
+            best = candidate;
+            best_seconds = seconds;
+        }
+    }
+
+    save_tuning_profile(best);
+    std::printf("fastest: local size %d, tile size %d, %s, written to %s\n", best.local_size, best.tile_size,
+                best.use_grid ? "grid" : "all pairs", TUNING_PROFILE_PATH);
+    std::printf("%s\n", PROGRAM_CACHE.summary().c_str());
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <BarnesHutTree.h>
+#include <ParticleLenia2DCpu.h>
+#include <ParticleLeniaCore.h>
+
+/**
+ * U and grad U at position summed over all particles in double precision, accumulated like
+ * ParticleLeniaCore::analytic_gradient_of, as the reference for the tree.
+ */
+template<int Dim>
+static void exact_U(const ParticleLeniaCore<Dim, double> &core, const std::array<const float *, Dim> &positions,
+                    int num_particles, const std::array<float, Dim> &position, double &u,
+                    std::array<double, Dim> &grad_u) {
+    u = 0.0;
+    grad_u.fill(0.0);
+    for (int j = 0; j < num_particles; ++j) {
+        typename ParticleLeniaCore<Dim, double>::Vector difference;
+        for (int d = 0; d < Dim; ++d) difference[d] = (double) position[d] - positions[d][j];
+        double norm = core.euclid_norm(difference);
+        u += core.K(norm);
+        if (norm >= core.r_distance) {
+            double k = core.K_derivative(norm) / norm;
+            for (int d = 0; d < Dim; ++d) grad_u[d] += k * difference[d];
+        }
+    }
+}
+
+// reports the accuracy of the Barnes-Hut approximation of U and the seconds per step for increasing numbers of
+// particles
+// usage: barnes_hut_report [max_particles] [mu_k] [threads] [particles per unit area]
+int main(int argc, char **argv) {
+    int max_particles = argc > 1 ? std::atoi(argv[1]) : 100000;
+    // the tree only pays off when the shell of K reaches far beyond dense clusters, at the default mu_k = 4 and the
+    // density of the default 300 particles in a 30 x 30 area (0.93) no node is ever approximated
+    float mu_k = argc > 2 ? (float) std::atof(argv[2]) : 20.0f;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    float density = argc > 4 ? (float) std::atof(argv[4]) : 20.0f;
+
+    const std::vector<float> thetas{0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+    const int samples = 1000;
+
+    ParticleLenia2DCpu particle_lenia(threads);
+    particle_lenia.mu_k = mu_k;
+    const FieldParameters parameters = particle_lenia.field_parameters();
+    ParticleLeniaCore<2, double> reference_2d;
+    ParticleLeniaCore<3, double> reference_3d;
+    reference_2d.w_k = reference_3d.w_k = particle_lenia.w_k;
+    reference_2d.mu_k = reference_3d.mu_k = particle_lenia.mu_k;
+    reference_2d.sigma_k2 = reference_3d.sigma_k2 = particle_lenia.sigma_k2;
+    reference_2d.r_distance = reference_3d.r_distance = particle_lenia.r_distance;
+
+    auto width_for = [&](int num_particles) {
+        return std::sqrt(num_particles / density) / 0.6f;
+    };
+
+    // accuracy against the exact sums over all particles, the errors of U are relative to the mean of U (single
+    // positions can have U close to 0) and the error of the gradient is absolute. U is sampled at mu_k from the first
+    // particles in random directions, since the cloud can be smaller than the shell of K and U inside of it would only
+    // consist of values below w_k * e^-9
+    {
+        const int num_particles = std::min(max_particles, 20000);
+        particle_lenia.num_particles = num_particles;
+        particle_lenia.reset_particles(width_for(num_particles), 0);
+        BarnesHutTree<2> tree;
+        tree.build({particle_lenia.x.data(), particle_lenia.y.data()}, num_particles);
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        std::printf("2D accuracy of U, %d particles, %.2f per unit area, mu_k = %.2f, %d samples\n", num_particles,
+                    density, mu_k, samples);
+        std::printf("%8s %16s %16s %18s\n", "theta", "max error", "rms error", "max grad error");
+        for (float theta: thetas) {
+            double max_error = 0.0, squared_error = 0.0, max_gradient_error = 0.0, sum_u = 0.0;
+            int count = std::min(samples, num_particles);
+            for (int i = 0; i < count; ++i) {
+                float a = angle(rng);
+                std::array<float, 2> position{particle_lenia.x[i] + mu_k * std::cos(a),
+                                              particle_lenia.y[i] + mu_k * std::sin(a)};
+                float u = 0.0f;
+                std::array<float, 2> grad_u{0.0f, 0.0f};
+                tree.add_U(parameters, theta, position, u, grad_u);
+
+                double exact;
+                std::array<double, 2> exact_grad;
+                exact_U<2>(reference_2d, {particle_lenia.x.data(), particle_lenia.y.data()}, num_particles,
+                           position, exact, exact_grad);
+
+                double error = std::fabs(u - exact);
+                max_error = std::max(max_error, error);
+                squared_error += error * error;
+                sum_u += exact;
+                max_gradient_error = std::max(max_gradient_error, (double) std::hypot(grad_u[0] - exact_grad[0],
+                                                                                      grad_u[1] - exact_grad[1]));
+            }
+            double mean_u = sum_u / count;
+            std::printf("%8.2f %16.3e %16.3e %18.3e\n", theta, max_error / mean_u,
+                        std::sqrt(squared_error / count) / mean_u, max_gradient_error);
+        }
+    }
+
+    // the octree is checked against a plain sum over all particles, the cpu engine is only 2D
+    {
+        const int num_particles = std::min(max_particles, 20000);
+        // density is used per unit volume
+        const float width = std::cbrt(num_particles / density) / 0.6f;
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> distribution(-0.3f * width, 0.3f * width);
+        std::normal_distribution<float> normal;
+        std::array<std::vector<float>, 3> positions;
+        for (auto &coordinates: positions) {
+            coordinates.resize(num_particles);
+            for (float &coordinate: coordinates) coordinate = distribution(rng);
+        }
+        BarnesHutTree<3> tree;
+        tree.build({positions[0].data(), positions[1].data(), positions[2].data()}, num_particles);
+
+        std::printf("\n3D accuracy of U, %d particles, %.2f per unit volume\n", num_particles,
+                    num_particles / std::pow(0.6f * width, 3.0f));
+        std::printf("%8s %16s %16s %18s\n", "theta", "max error", "rms error", "max grad error");
+        for (float theta: thetas) {
+            double max_error = 0.0, squared_error = 0.0, max_gradient_error = 0.0, sum_u = 0.0;
+            int count = std::min(samples, num_particles);
+            for (int i = 0; i < count; ++i) {
+                std::array<float, 3> direction{normal(rng), normal(rng), normal(rng)};
+                float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                         direction[2] * direction[2]);
+                std::array<float, 3> position;
+                for (int d = 0; d < 3; ++d) position[d] = positions[d][i] + mu_k * direction[d] / length;
+                float u = 0.0f;
+                std::array<float, 3> grad_u{0.0f, 0.0f, 0.0f};
+                tree.add_U(parameters, theta, position, u, grad_u);
+
+                double exact;
+                std::array<double, 3> exact_grad;
+                exact_U<3>(reference_3d, {positions[0].data(), positions[1].data(), positions[2].data()},
+                           num_particles, position, exact, exact_grad);
+
+                double error = std::fabs(u - exact);
+                max_error = std::max(max_error, error);
+                squared_error += error * error;
+                sum_u += exact;
+                max_gradient_error = std::max(max_gradient_error,
+                                              std::sqrt(std::pow(grad_u[0] - exact_grad[0], 2.0) +
+                                                        std::pow(grad_u[1] - exact_grad[1], 2.0) +
+                                                        std::pow(grad_u[2] - exact_grad[2], 2.0)));
+            }
+            double mean_u = sum_u / count;
+            std::printf("%8.2f %16.3e %16.3e %18.3e\n", theta, max_error / mean_u,
+                        std::sqrt(squared_error / count) / mean_u, max_gradient_error);
+        }
+    }
+
+    // seconds for one step of each neighbour search, all pairs is skipped where it would take too long
+    std::printf("\nseconds per step (theta = %.2f, %d threads)\n", particle_lenia.barnes_hut_theta,
+                particle_lenia.get_num_threads());
+    std::printf("%10s %12s %12s %12s\n", "particles", "all pairs", "cell list", "barnes-hut");
+    for (int num_particles = 1000; num_particles <= max_particles; num_particles *= 10) {
+        particle_lenia.num_particles = num_particles;
+        particle_lenia.reset_particles(width_for(num_particles), 0);
+        const std::vector<float> initial = particle_lenia.get_particles();
+
+        auto seconds_per_step = [&](NeighbourSearch search) {
+            particle_lenia.neighbour_search = search;
+            particle_lenia.set_particles(initial);
+            auto start = std::chrono::steady_clock::now();
+            particle_lenia.step(1);
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        double all_pairs = num_particles <= 100000 ? seconds_per_step(NeighbourSearch::ALL_PAIRS) : NAN;
+        double cell_list = seconds_per_step(NeighbourSearch::CELL_LIST);
+        double barnes_hut = seconds_per_step(NeighbourSearch::BARNES_HUT);
+        std::printf("%10d %12.4f %12.4f %12.4f\n", num_particles, all_pairs, cell_list, barnes_hut);
+    }
+}
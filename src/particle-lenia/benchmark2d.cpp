@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <ParticleLenia2DCpu.h>
+
+// measures the steps per second of the cpu simulation for an increasing number of threads
+// usage: benchmark2d [num_particles] [steps] [max_threads] [scalar|avx2|avx512]
+//                    [all|symmetric|cells|verlet|barnes-hut|particle-mesh]
+int main(int argc, char **argv) {
+    int num_particles = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 3;
+    int max_threads = argc > 3 ? std::atoi(argv[3]) : (int) std::thread::hardware_concurrency();
+    if (max_threads < 1) max_threads = 1;
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    ParticleLenia2DCpu particle_lenia(1);
+    if (argc > 4) {
+        if (std::strcmp(argv[4], "scalar") == 0) particle_lenia.set_kernel_path(FieldKernelPath::SCALAR);
+        else if (std::strcmp(argv[4], "avx2") == 0) particle_lenia.set_kernel_path(FieldKernelPath::AVX2);
+    }
+    if (argc > 5 && std::strcmp(argv[5], "symmetric") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::SYMMETRIC_PAIRS;
+    }
+    if (argc > 5 && std::strcmp(argv[5], "cells") == 0) particle_lenia.neighbour_search = NeighbourSearch::CELL_LIST;
+    if (argc > 5 && std::strcmp(argv[5], "verlet") == 0) particle_lenia.neighbour_search = NeighbourSearch::VERLET_LIST;
+    if (argc > 5 && std::strcmp(argv[5], "barnes-hut") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::BARNES_HUT;
+    }
+    if (argc > 5 && std::strcmp(argv[5], "particle-mesh") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::PARTICLE_MESH;
+    }
+    particle_lenia.num_particles = num_particles;
+    particle_lenia.reset_particles(30, 0);
+    const std::vector<float> initial = particle_lenia.get_particles();
+
+    std::printf("%d particles, %d steps per measurement, %s field kernel\n", num_particles, steps,
+                field_kernel_path_name(particle_lenia.get_kernel_path()));
+    std::printf("%8s %12s %10s %11s\n", "threads", "steps/s", "speedup", "efficiency");
+
+    double single_thread = 0.0;
+    for (int threads: thread_counts) {
+        particle_lenia.set_num_threads(threads);
+        particle_lenia.set_particles(initial);
+
+        auto start = std::chrono::steady_clock::now();
+        particle_lenia.step(steps);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double steps_per_second = steps / seconds;
+        if (threads == 1) single_thread = steps_per_second;
+        double speedup = steps_per_second / single_thread;
+        std::printf("%8d %12.3f %10.2f %10.1f%%\n", threads, steps_per_second, speedup, 100.0 * speedup / threads);
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef PARTICLE_LENIA_FIELD_VOLUME_HPP
+#define PARTICLE_LENIA_FIELD_VOLUME_HPP
+
+#include <GLFWAbstraction.h>
+#include <array>
+#include <cstring>
+
+#include "lenia_params.hpp"
+#include "particle_grid.hpp"
+#include "particle_layout.hpp"
+
+/**
+ * U, R, G and E of the 3D version sampled at the centers of resolution^3 voxels of a cube, stored in an RGBA32F
+ * 3D texture. field_volume.comp fills it with one invocation per voxel, shaders that show the fields then sample the
+ * texture instead of summing up all particles per pixel, so drawing them doesn't depend on the number of particles.
+ * current() tells whether the particles or anything else the samples depend on changed since the last evaluation,
+ * callers only evaluate() if they did, so a paused simulation doesn't evaluate the fields at all.
+ */
+class FieldVolume {
+public:
+    // voxels per axis
+    int resolution = 64;
+    // the cube has edge length extent and is centered at center
+    std::array<float, 3> center{0, 0, 0};
+    float extent = 30;
+
+    // u, r, g, e per voxel
+    Texture texture;
+    // number of times the fields were sampled, shaders that derive something from the volume compare it
+    long evaluations = 0;
+
+    /**
+     * Compiles field_volume.comp, MUST be called after glfw has been initialized.
+     * @param prefix ParticleGrid::shader_prefix() of the grid passed to evaluate()
+     */
+    void init(const std::string &prefix) {
+        shader.init(prefix);
+        ParticleLayout(3).validate(shader, "ParticlesBuffer");
+    }
+
+    // position of the corner of the first voxel
+    std::array<float, 3> origin() const {
+        return {center[0] - extent / 2, center[1] - extent / 2, center[2] - extent / 2};
+    }
+
+    float voxel_size() const {
+        return extent / (float) resolution;
+    }
+
+    /**
+     * Whether the texture holds the fields of these inputs already, then evaluate() can be skipped.
+     * @param particles_version changes whenever the particles in the buffers change
+     * @param cutoff cutoff radius of the grid, only compared if use_grid is set
+     */
+    bool current(long particles_version, const LeniaParams &params, bool use_grid, float cutoff) const {
+        return evaluations > 0 && inputs(particles_version, params, use_grid, cutoff) == evaluated;
+    }
+
+    /**
+     * Samples the fields of the particles into the texture.
+     * @param particles current particle buffer
+     * @param particles_version see current()
+     * @param grid grid built for the current particles, only bound if use_grid is set
+     * @param params_buffer already holds params, it is bound to the shader
+     */
+    void evaluate(const Buffer &particles, long particles_version, const ParticleGrid &grid, bool use_grid,
+                  const LeniaParamsBuffer &params_buffer, const LeniaParams &params) {
+        if (texture.width != resolution) {
+            texture = Texture(resolution, resolution, resolution, GL_RGBA32F, GL_FLOAT, GL_RGBA);
+            texture.init();
+        }
+
+        shader.bind_buffer("ParticlesBuffer", particles, 0);
+        shader.use();
+        grid.bind(shader, use_grid, 1);
+        params_buffer.bind(shader);
+        shader.bind_uniform("field_volume", texture, 0, GL_WRITE_ONLY);
+        shader.bind_uniform("volume_origin", origin());
+        shader.bind_uniform("voxel_size", voxel_size());
+        // 4^3 invocations per workgroup
+        GLuint groups = (resolution + 3) / 4;
+        shader.dispatch(groups, groups, groups);
+        shader.wait(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        evaluated = inputs(particles_version, params, use_grid, grid.cutoff);
+        ++evaluations;
+    }
+
+private:
+    // everything the samples depend on
+    struct Inputs {
+        long particles_version;
+        LeniaParams params;
+        int resolution;
+        std::array<float, 3> center;
+        float extent;
+        bool use_grid;
+        float cutoff;
+
+        bool operator==(const Inputs &other) const {
+            // LeniaParams has no padding, LeniaParamsBuffer compares it the same way
+            return particles_version == other.particles_version &&
+                   std::memcmp(&params, &other.params, sizeof(LeniaParams)) == 0 && resolution == other.resolution &&
+                   center == other.center && extent == other.extent && use_grid == other.use_grid &&
+                   cutoff == other.cutoff;
+        }
+    };
+
+    Inputs inputs(long particles_version, const LeniaParams &params, bool use_grid, float cutoff) const {
+        return Inputs{particles_version, params, resolution, center, extent, use_grid, use_grid ? cutoff : 0.0f};
+    }
+
+    SimpleComputeShader shader = SimpleComputeShader("shaders/particle-lenia/3d/field_volume.generated.comp");
+    Inputs evaluated{};
+};
+
+#endif //PARTICLE_LENIA_FIELD_VOLUME_HPP
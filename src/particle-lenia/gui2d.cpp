@@ -2,7 +2,10 @@
 #include <imgui/imgui_impl_glfw.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include <fstream>
+
 #include "particle_lenia_2d.hpp"
+#include "tuning_profile.hpp"
 
 bool pause = false;
 int steps_per_frame = 10;
@@ -94,21 +97,65 @@ bool render_loop_call(GLFWwindow *window) {
         }
         {
             ImGui::Text("Misc");
+            ImGui::Checkbox("Analytic gradient", &particle_lenia.analytic_gradient);
             if (ImGui::SliderFloat("h (gradient evaluation distance)", &particle_lenia.h, 0.f, 0.1f)) {
                 particle_lenia.h2 = 2 * particle_lenia.h;
                 if (reset_on_change) particle_lenia.reset_particles();
             }
             if (ImGui::SliderFloat("dt", &particle_lenia.dt, 0.f, 3.f) && reset_on_change)
                 particle_lenia.reset_particles();
-            if (ImGui::SliderInt("Number of Particles", &particle_lenia.num_particles, 0, 2500)) {
+            ImGui::Checkbox("Use grid (cutoff radius)", &particle_lenia.use_grid);
+            if (particle_lenia.use_grid) {
+                ImGui::SliderFloat("Cutoff tolerance", &particle_lenia.cutoff_tolerance, 1e-9f, 1e-2f, "%.1e",
+                                   ImGuiSliderFlags_Logarithmic);
+                ImGui::Text("Cutoff radius %.2f", particle_lenia.cutoff_radius());
+            }
+            // the mesh is rebuilt every frame from the particles downloaded to the cpu
+            ImGui::Checkbox("Particle Mesh Fields", &particle_lenia.use_particle_mesh);
+            // the grid makes the cost per particle independent of the number of particles
+            if (ImGui::SliderInt("Number of Particles", &particle_lenia.num_particles, 0,
+                                 particle_lenia.use_grid ? 200000 : 2500)) {
                 particle_lenia.resize_buffer(reset_on_change);
             }
             ImGui::SliderInt("Steps per frame", &steps_per_frame, 1, 1000);
+            // variants are built in the background once the sliders haven't moved for a moment
+            ImGui::Checkbox("Specialize shaders for the current parameters", &particle_lenia.specialize);
+            if (particle_lenia.specialize) {
+                ImGui::Text("%s, %d variants cached (%d built)",
+                            particle_lenia.variant ? "specialized" : "generic until the variant is ready",
+                            particle_lenia.variants.size(), particle_lenia.variants.built);
+            }
         }
 
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
                     ImGui::GetIO().Framerate);
         ImGui::Text("Application average %.3f ms/step", (1000.0f / ImGui::GetIO().Framerate) / steps_per_frame);
+        ImGui::Text("Submission %.2f us/step", particle_lenia.submit_microseconds_per_step);
+        // live objects that keep growing are a leak, created objects that keep growing are reallocations
+        ImGui::Text("%s", GL_OBJECTS.summary().c_str());
+
+        // every step is copied back asynchronously and written as one "x y" pair per particle and line
+        static bool export_trajectory = false;
+        static std::ofstream trajectory;
+        if (ImGui::Checkbox("Export trajectory to particle_lenia_trajectory.txt", &export_trajectory)) {
+            if (export_trajectory) {
+                trajectory.open("particle_lenia_trajectory.txt");
+                particle_lenia.on_step = [](long step, const float *particles, int num_particles) {
+                    trajectory << "# step " << step << "\n";
+                    for (int i = 0; i < num_particles; ++i) {
+                        trajectory << particles[2 * i] << " " << particles[2 * i + 1] << "\n";
+                    }
+                };
+            } else {
+                particle_lenia.step_readback.finish();
+                particle_lenia.on_step = nullptr;
+                trajectory.close();
+            }
+        }
+        if (export_trajectory) {
+            ImGui::Text("%d steps in flight, %ld stalls", particle_lenia.step_readback.pending(),
+                        particle_lenia.step_readback.stalls);
+        }
 
         ImGui::End();
     }
@@ -117,8 +164,8 @@ bool render_loop_call(GLFWwindow *window) {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
     if (ImGui::IsKeyPressed(ImGuiKey_A, true)) {
-        ++particle_lenia.num_particles;
-        particle_lenia.resize_buffer(false, false, particle_lenia.translate_mouse_position(true));
+        ImVec2 position = particle_lenia.translate_mouse_position(true);
+        particle_lenia.append_particles({position.x, position.y});
     }
 
     static ImVec2 source_position;
@@ -149,7 +196,18 @@ bool render_loop_call(GLFWwindow *window) {
 }
 
 void call_after_glfw_init(GLFWwindow *window) {
+    // written by autotune for this device, the defaults are kept otherwise
+    TuningProfile profile;
+    if (load_tuning_profile(profile)) {
+        particle_lenia.local_size = profile.local_size;
+        particle_lenia.tile_size = profile.tile_size;
+        particle_lenia.use_grid = profile.use_grid;
+        std::cout << "loaded tuning profile: local size " << profile.local_size << ", tile size "
+                  << profile.tile_size << (profile.use_grid ? ", grid" : ", all pairs") << std::endl;
+    }
     particle_lenia.init();
+    // cold start if shaders had to be compiled, warm start if all came from the program cache
+    std::cout << PROGRAM_CACHE.summary() << std::endl;
 
     // ImGui setup following
     // Setup Dear ImGui context
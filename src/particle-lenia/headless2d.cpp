@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <ParticleLenia2DCpu.h>
+
+// runs the 2D simulation on the cpu without a window or an OpenGL context
+// usage: headless2d [num_particles] [steps] [output file] [seed] [threads]
+//                   [all|symmetric|cells|verlet|barnes-hut|particle-mesh]
+int main(int argc, char **argv) {
+    ParticleLenia2DCpu particle_lenia(argc > 5 ? std::atoi(argv[5]) : 0);
+    particle_lenia.num_particles = argc > 1 ? std::atoi(argv[1]) : 300;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const char *output = argc > 3 ? argv[3] : nullptr;
+    unsigned int seed = argc > 4 ? (unsigned int) std::strtoul(argv[4], nullptr, 10) : 0;
+
+    if (argc > 6 && std::strcmp(argv[6], "symmetric") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::SYMMETRIC_PAIRS;
+    }
+    if (argc > 6 && std::strcmp(argv[6], "cells") == 0) particle_lenia.neighbour_search = NeighbourSearch::CELL_LIST;
+    if (argc > 6 && std::strcmp(argv[6], "verlet") == 0) particle_lenia.neighbour_search = NeighbourSearch::VERLET_LIST;
+    if (argc > 6 && std::strcmp(argv[6], "barnes-hut") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::BARNES_HUT;
+    }
+    if (argc > 6 && std::strcmp(argv[6], "particle-mesh") == 0) {
+        particle_lenia.neighbour_search = NeighbourSearch::PARTICLE_MESH;
+    }
+
+    // keep the density of the default 300 particles in a 30 x 30 area for larger numbers of particles
+    particle_lenia.reset_particles(30 * std::sqrt(std::max(particle_lenia.num_particles, 300) / 300.0f), seed);
+
+    auto start = std::chrono::steady_clock::now();
+    particle_lenia.step(steps);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << particle_lenia.num_particles << " particles, " << steps << " steps in " << seconds << " s ("
+              << steps / seconds << " steps/s) with the " << field_kernel_path_name(particle_lenia.get_kernel_path())
+              << " field kernel" << std::endl;
+    if (particle_lenia.neighbour_search == NeighbourSearch::VERLET_LIST) {
+        const VerletListStatistics &statistics = particle_lenia.verlet_statistics;
+        std::cout << "verlet lists: " << statistics.rebuilds << " rebuilds in " << statistics.steps << " steps, "
+                  << statistics.average_length << " neighbours per particle" << std::endl;
+    }
+
+    // write the final particle positions as one "x y" pair per line
+    if (output) {
+        std::ofstream file(output);
+        for (int i = 0; i < particle_lenia.num_particles; ++i) {
+            file << particle_lenia.x[i] << " " << particle_lenia.y[i] << "\n";
+        }
+    }
+}
@@ -0,0 +1,197 @@
+#ifndef PARTICLE_LENIA_ISO_SURFACE_HPP
+#define PARTICLE_LENIA_ISO_SURFACE_HPP
+
+#include <GLFWAbstraction.h>
+#include <algorithm>
+#include <array>
+#include <map>
+#include <vector>
+
+#include "field_volume.hpp"
+
+/**
+ * Surface where one field of a FieldVolume equals iso, extracted with marching cubes on the gpu.
+ * marching_cubes.comp runs one invocation per cell between eight neighbouring voxels and appends the triangles of its
+ * cell to the vertex buffer, the vertices are allocated with an atomic add on the vertex count of the draw command.
+ * A second pass cuts that count off at the first cell that didn't fit into the buffer anymore.
+ * The surface is then drawn with glDrawArraysIndirect from that command, so the cpu never learns how many triangles
+ * there are and nothing is read back. Like the volume, it is only extracted again once the volume was evaluated again
+ * or a setting of the surface changed.
+ */
+class IsoSurface {
+public:
+    // entries per case in the triangle table: at most 5 triangles with 3 vertices each, then -1
+    static const int ENTRIES_PER_CASE = 16;
+
+    // channel of the volume the surface is extracted from: 0 U, 1 R, 2 G, 3 E
+    int field = 0;
+    // the surface separates the voxels with field values >= iso from the others
+    float iso = 0.3f;
+    // triangles of cells that don't fit into the buffer anymore are dropped
+    int max_triangles = 1 << 18;
+    std::array<float, 4> color{0.9f, 0.6f, 0.2f, 1.0f};
+
+    // number of times the surface was extracted
+    long extractions = 0;
+
+    // compiles the shaders and uploads the triangle table, MUST be called after glfw has been initialized
+    void init() {
+        extract_shader.init_without_arguments();
+        draw_shader.init_without_arguments();
+
+        std::vector<int> table = triangle_table();
+        triangles = Buffer((int) table.size(), GL_SHADER_STORAGE_BUFFER);
+        triangles.init();
+        triangles.set_data(table.data(), (GLsizeiptr) (table.size() * sizeof(int)));
+
+        // the draw command and the overflow start
+        command = Buffer(5, GL_SHADER_STORAGE_BUFFER);
+        command.init();
+        // nothing to draw before the first extraction
+        reset_command();
+
+        glGenVertexArrays(1, &VAO);
+    }
+
+    // whether the surface belongs to the current samples of the volume, then extract() can be skipped
+    bool current(const FieldVolume &volume) const {
+        return extractions > 0 && inputs(volume) == extracted;
+    }
+
+    // extracts the surface of the current samples of the volume
+    void extract(const FieldVolume &volume) {
+        int max_vertices = 3 * max_triangles;
+        // position and normal as vec4 each
+        if (vertices.size != 8 * max_vertices) {
+            vertices = Buffer(8 * max_vertices, GL_SHADER_STORAGE_BUFFER);
+            vertices.init();
+        }
+        reset_command();
+
+        extract_shader.use();
+        extract_shader.bind_uniform("field_volume", volume.texture, 0, GL_READ_ONLY);
+        extract_shader.bind_uniform("volume_origin", volume.origin());
+        extract_shader.bind_uniform("voxel_size", volume.voxel_size());
+        extract_shader.bind_uniform("field", field);
+        extract_shader.bind_uniform("iso", iso);
+        extract_shader.bind_uniform("max_vertices", max_vertices);
+        extract_shader.bind_buffer("TriangleTable", triangles, 0);
+        extract_shader.bind_buffer("SurfaceBuffer", vertices, 1);
+        extract_shader.bind_buffer("DrawCommand", command, 2);
+        extract_shader.bind_uniform("marching_pass", 0);
+        // 4^3 cells per workgroup, there is one cell less than voxels per axis
+        GLuint groups = (volume.resolution - 1 + 3) / 4;
+        extract_shader.dispatch(groups, groups, groups);
+        extract_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        extract_shader.bind_uniform("marching_pass", 1);
+        extract_shader.dispatch(1, 1, 1);
+        extract_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        extracted = inputs(volume);
+        ++extractions;
+    }
+
+    // draws the surface lit from the viewer, with the same view as the particles
+    void draw(const std::array<float, 9> &rotation, const std::array<float, 3> &translate,
+              const std::array<float, 3> &scale) const {
+        draw_shader.bind_buffer("SurfaceBuffer", vertices, 0);
+        draw_shader.use();
+        draw_shader.bind_uniform("rotation", rotation);
+        draw_shader.bind_uniform("translate", translate);
+        draw_shader.bind_uniform("scale", scale);
+        draw_shader.bind_uniform("surface_color", color);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindVertexArray(VAO);
+        glEnable(GL_DEPTH_TEST);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command.id);
+        glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDisable(GL_DEPTH_TEST);
+    }
+
+    /**
+     * Triangles of the 256 cases of marching cubes, ENTRIES_PER_CASE per case. Corner c of a cell lies at
+     * (c & 1, c >> 1 & 1, c >> 2) and is inside if bit c of the case is set. Every vertex is given by the edge it lies
+     * on, as the corners a | b << 3, and -1 follows the last one.
+     * Instead of a hard coded table, the polygons are traced over the faces of the cell: on every face, each run of
+     * inside corners is cut off by a segment from the edge where the run starts to the edge where it ends. Faces with
+     * two diagonal inside corners therefore always separate them, neighbouring cells agree on their shared face and the
+     * surface has no holes. The segments chain up to closed polygons, which are triangulated as fans.
+     */
+    static std::vector<int> triangle_table() {
+        // faces counterclockwise seen from outside, so every edge is walked once in each direction
+        const int faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+
+        std::vector<int> table(256 * ENTRIES_PER_CASE, -1);
+        for (int index = 0; index < 256; ++index) {
+            auto inside = [index](int corner) { return (index >> corner & 1) == 1; };
+            auto edge = [](int a, int b) { return std::min(a, b) | std::max(a, b) << 3; };
+
+            // edge where a run of inside corners starts -> edge where it ends, on the face where the run lies
+            std::map<int, int> next;
+            for (const auto &face : faces) {
+                for (int k = 0; k < 4; ++k) {
+                    if (inside(face[k]) || !inside(face[(k + 1) % 4])) continue;
+                    int end = (k + 1) % 4;
+                    while (inside(face[(end + 1) % 4])) end = (end + 1) % 4;
+                    next[edge(face[k], face[(k + 1) % 4])] = edge(face[end], face[(end + 1) % 4]);
+                }
+            }
+
+            int entry = index * ENTRIES_PER_CASE;
+            while (!next.empty()) {
+                std::vector<int> polygon;
+                for (int e = next.begin()->first; next.count(e); ) {
+                    polygon.push_back(e);
+                    int following = next[e];
+                    next.erase(e);
+                    e = following;
+                }
+                for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                    table[entry++] = polygon[0];
+                    table[entry++] = polygon[i];
+                    table[entry++] = polygon[i + 1];
+                }
+            }
+        }
+        return table;
+    }
+
+private:
+    // everything the surface depends on
+    struct Inputs {
+        long evaluations;
+        int field;
+        float iso;
+        int max_triangles;
+
+        bool operator==(const Inputs &other) const {
+            return evaluations == other.evaluations && field == other.field && iso == other.iso &&
+                   max_triangles == other.max_triangles;
+        }
+    };
+
+    Inputs inputs(const FieldVolume &volume) const {
+        return Inputs{volume.evaluations, field, iso, max_triangles};
+    }
+
+    // DrawArraysIndirectCommand with no vertices and one instance, no cell overflowed yet
+    void reset_command() const {
+        const GLuint empty[5] = {0, 1, 0, 0, 0xFFFFFFFFu};
+        command.set_data(empty, sizeof(empty));
+    }
+
+    SimpleComputeShader extract_shader = SimpleComputeShader("shaders/particle-lenia/3d/marching_cubes.comp");
+    SimpleShader draw_shader = SimpleShader("shaders/particle-lenia/3d/surface_3d.vert",
+                                            "shaders/particle-lenia/3d/surface_3d.frag");
+    Buffer triangles;
+    Buffer vertices;
+    // the indirect draw command, its vertex count is the append counter of the vertices, followed by the overflow start
+    Buffer command;
+    unsigned int VAO = 0;
+    Inputs extracted{};
+};
+
+#endif //PARTICLE_LENIA_ISO_SURFACE_HPP
@@ -0,0 +1,69 @@
+#ifndef PARTICLE_LENIA_LENIA_PARAMS_HPP
+#define PARTICLE_LENIA_LENIA_PARAMS_HPP
+
+#include <GLFWAbstraction.h>
+#include <ParticleLeniaCore.h>
+#include <cstring>
+
+// mirrors the std140 uniform block LeniaParams of fields_functions.glsl,
+// it only holds 4 byte scalars, which std140 packs without any padding
+struct LeniaParams {
+    float w_k;
+    float mu_k;
+    float sigma_k2;
+    float mu_g;
+    float sigma_g2;
+    float c_rep;
+    float r_distance;
+    int num_particles;
+    float h;
+    float h2;
+    float dt;
+    // bools take 4 bytes in std140
+    int analytic_gradient;
+};
+
+// the LeniaParams block for the parameters of a simulation
+template<int Dim>
+LeniaParams lenia_params(const ParticleLeniaCore<Dim, float> &core) {
+    return LeniaParams{core.w_k, core.mu_k, core.sigma_k2, core.mu_g, core.sigma_g2, core.c_rep, core.r_distance,
+                       core.num_particles, core.h, core.h2, core.dt, core.analytic_gradient};
+}
+
+/**
+ * Uniform buffer with the LeniaParams block of all shaders.
+ * The parameters are only uploaded when they differ from the last upload, so sliders that don't move cost nothing.
+ */
+class LeniaParamsBuffer {
+public:
+    // uniform buffer binding point used by every shader
+    static const int BINDING_POINT = 0;
+
+    // number of uploads so far
+    long uploads = 0;
+
+    // creates the buffer, MUST be called after glfw has been initialized
+    void init() {
+        buffer.init();
+    }
+
+    // uploads the parameters if they changed since the last upload
+    void update(const LeniaParams &params) {
+        if (uploads > 0 && std::memcmp(&params, &uploaded, sizeof(LeniaParams)) == 0) return;
+        buffer.set_data(&params, sizeof(LeniaParams));
+        uploaded = params;
+        ++uploads;
+    }
+
+    // binds the buffer to the LeniaParams block of a shader
+    template<typename Shader>
+    void bind(const Shader &shader) const {
+        shader.bind_uniform_block("LeniaParams", buffer, BINDING_POINT);
+    }
+
+private:
+    Buffer buffer = Buffer(sizeof(LeniaParams) / sizeof(float), GL_UNIFORM_BUFFER);
+    LeniaParams uploaded{};
+};
+
+#endif //PARTICLE_LENIA_LENIA_PARAMS_HPP
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <ParticleLenia2DCpu.h>
+
+// compares the neighbour searches of the cpu simulation with ALL_PAIRS and exits with 1 if one of them drifts away
+// usage: neighbour_search_check
+
+// largest difference of a coordinate after stepping the same particles with search and with ALL_PAIRS
+static float drift(ParticleLenia2DCpu &particle_lenia, const std::vector<float> &initial, NeighbourSearch search,
+                   int steps) {
+    particle_lenia.neighbour_search = NeighbourSearch::ALL_PAIRS;
+    particle_lenia.set_particles(initial);
+    particle_lenia.step(steps);
+    std::vector<float> expected = particle_lenia.get_particles();
+
+    particle_lenia.neighbour_search = search;
+    particle_lenia.set_particles(initial);
+    particle_lenia.step(steps);
+    std::vector<float> actual = particle_lenia.get_particles();
+
+    float difference = 0;
+    for (size_t i = 0; i < expected.size(); ++i) difference = std::max(difference, std::fabs(actual[i] - expected[i]));
+    return difference;
+}
+
+int main() {
+    ParticleLenia2DCpu particle_lenia(4);
+    particle_lenia.num_particles = 500;
+    // with a small mu_k, K(0) is large, so leaving out the particle itself in U shows up right away
+    particle_lenia.mu_k = 0.5f;
+    particle_lenia.reset_particles(30, 1);
+    const std::vector<float> initial = particle_lenia.get_particles();
+
+    bool failed = false;
+    float symmetric = drift(particle_lenia, initial, NeighbourSearch::SYMMETRIC_PAIRS, 5);
+    std::printf("symmetric pairs vs all pairs: %g\n", symmetric);
+    failed |= !(symmetric < 1e-4f);
+
+    // verlet lists built before another search moved the particles must not be reused afterwards. Both runs only
+    // differ in their last steps, so CELL_LIST (which finds the neighbours anew every step) is the reference
+    particle_lenia.mu_k = 4.0f;
+    std::vector<float> switched[2];
+    const NeighbourSearch last_search[2] = {NeighbourSearch::CELL_LIST, NeighbourSearch::VERLET_LIST};
+    for (int run = 0; run < 2; ++run) {
+        particle_lenia.set_particles(initial);
+        particle_lenia.neighbour_search = NeighbourSearch::VERLET_LIST;
+        particle_lenia.step(5);
+        // large steps move the particles far beyond the skin of the lists
+        particle_lenia.dt = 1.0f;
+        particle_lenia.neighbour_search = NeighbourSearch::ALL_PAIRS;
+        particle_lenia.step(20);
+        particle_lenia.dt = 0.1f;
+        particle_lenia.neighbour_search = last_search[run];
+        particle_lenia.step(5);
+        switched[run] = particle_lenia.get_particles();
+    }
+    float verlet = 0;
+    for (size_t i = 0; i < initial.size(); ++i) verlet = std::max(verlet, std::fabs(switched[1][i] - switched[0][i]));
+    std::printf("verlet lists after switching searches vs cell list: %g\n", verlet);
+    failed |= !(verlet < 1e-3f);
+
+    // mesh sizes that aren't powers of two are rounded up, 200 has to behave exactly like 256
+    particle_lenia.neighbour_search = NeighbourSearch::PARTICLE_MESH;
+    std::vector<float> meshed[2];
+    const int mesh_sizes[2] = {256, 200};
+    for (int run = 0; run < 2; ++run) {
+        particle_lenia.mesh_size = mesh_sizes[run];
+        particle_lenia.set_particles(initial);
+        particle_lenia.step(2);
+        meshed[run] = particle_lenia.get_particles();
+    }
+    bool same_mesh = meshed[0] == meshed[1];
+    std::printf("particle mesh of size 200 vs 256: %s\n", same_mesh ? "equal" : "different");
+    failed |= !same_mesh;
+    return failed ? 1 : 0;
+}
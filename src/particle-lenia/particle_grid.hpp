@@ -0,0 +1,181 @@
+#ifndef PARTICLE_LENIA_PARTICLE_GRID_HPP
+#define PARTICLE_LENIA_PARTICLE_GRID_HPP
+
+#include <GLFWAbstraction.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "particle_layout.hpp"
+
+/**
+ * Bins particles into the cells of a uniform grid on the gpu with a counting sort:
+ * grid_count.comp hashes every particle into a slot of the cell hash table and counts the particles per slot,
+ * grid_scan.comp turns the counts into start offsets with a parallel prefix sum and grid_scatter.comp copies the
+ * particles into a cell sorted buffer. Shaders that use the grid then only visit the particles of neighbouring cells.
+ * Works for the particle buffers of the 2D and the 3D version (see ParticleLayout).
+ */
+class ParticleGrid {
+public:
+    // number of slots in the hash table of cells, a power of two between 1024 and 1024^2 (limits of grid_scan.comp)
+    int grid_cells = 1 << 16;
+    // edge length of the cells, at least the cutoff
+    float cell_size = 1;
+    // particles that are further away are ignored by the shaders using the grid
+    float cutoff = 1;
+
+    // number of particles per slot
+    Buffer cell_count;
+    // index of the first particle of each slot in sorted_particles
+    Buffer cell_start;
+    // totals of the scan blocks
+    Buffer block_sums;
+    // slot and position within the slot of every particle
+    Buffer particle_cells;
+    // particles sorted by slot
+    Buffer sorted_particles;
+
+    explicit ParticleGrid(int dimension) : dimension(dimension) {}
+
+    /**
+     * Code that has to be put after the version line of every shader that uses the grid (including the grid shaders),
+     * it contains ParticleLeniaCore::glsl_prefix() of the dimension (which defines DIMENSION and the vector types)
+     * and shaders/particle-lenia/grid/grid_functions.glsl.
+     */
+    std::string shader_prefix() const {
+        std::string grid_functions;
+        try {
+            std::ifstream file;
+            file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+            file.open("shaders/particle-lenia/grid/grid_functions.glsl");
+            std::stringstream file_stream;
+            file_stream << file.rdbuf();
+            grid_functions = file_stream.str();
+        } catch (const std::ifstream::failure &e) {
+            std::cerr << "failed to read grid_functions.glsl" << std::endl;
+        }
+        std::string core_prefix = dimension == 3 ? ParticleLeniaCore<3, float>::glsl_prefix()
+                                                 : ParticleLeniaCore<2, float>::glsl_prefix();
+        return core_prefix + grid_functions;
+    }
+
+    // creates the buffers and compiles the grid shaders, MUST be called after glfw has been initialized
+    void init(int num_particles) {
+        std::string prefix = shader_prefix();
+        count_shader.init(prefix);
+        scan_shader.init_without_arguments();
+        scatter_shader.init(prefix);
+        ParticleLayout layout(dimension);
+        layout.validate(count_shader, "ParticlesBuffer");
+        layout.validate(scatter_shader, "ParticlesBuffer");
+        layout.validate(scatter_shader, "SortedParticlesOutput");
+
+        cell_count = Buffer(grid_cells, GL_SHADER_STORAGE_BUFFER);
+        cell_start = Buffer(grid_cells, GL_SHADER_STORAGE_BUFFER);
+        block_sums = Buffer(num_blocks(), GL_SHADER_STORAGE_BUFFER);
+        cell_count.init();
+        cell_start.init();
+        block_sums.init();
+
+        resize(num_particles);
+    }
+
+    // makes room for num_particles in the per particle buffers, they grow geometrically and never shrink, so adding
+    // particles one at a time doesn't reallocate them every time (their content is rebuilt every step anyway)
+    void resize(int num_particles) {
+        int capacity = particle_cells.size / 2;
+        if (capacity >= num_particles) return;
+        capacity = std::max(num_particles, 2 * capacity);
+        particle_cells = Buffer(2 * capacity, GL_SHADER_STORAGE_BUFFER);
+        sorted_particles = Buffer(ParticleLayout(dimension).stride() * capacity, GL_SHADER_STORAGE_BUFFER);
+        particle_cells.init();
+        sorted_particles.init();
+    }
+
+    // sorts the particles into the grid, cell_size and cutoff have to be set before
+    // every pass only reads the buffers of the previous one, so the barriers only cover shader storage accesses
+    void build(const Buffer &particles, int num_particles) {
+        unsigned int particle_groups = (num_particles + 255) / 256;
+        if (particle_groups == 0) return;
+
+        cell_count.clear();
+
+        count_shader.use();
+        count_shader.bind_buffer("ParticlesBuffer", particles, 0);
+        count_shader.bind_buffer("GridCellCounter", cell_count, 1);
+        count_shader.bind_buffer("ParticleCells", particle_cells, 2);
+        bind_uniforms(count_shader);
+        count_shader.bind_uniform("num_particles", num_particles);
+        count_shader.dispatch(particle_groups, 1, 1);
+        count_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scan_shader.use();
+        scan_shader.bind_buffer("ScanInput", cell_count, 0);
+        scan_shader.bind_buffer("ScanOutput", cell_start, 1);
+        scan_shader.bind_buffer("BlockSums", block_sums, 2);
+        scan_shader.bind_uniform("scan_pass", 0);
+        scan_shader.bind_uniform("count", grid_cells);
+        scan_shader.dispatch(num_blocks(), 1, 1);
+        scan_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scan_shader.bind_buffer("ScanInput", block_sums, 0);
+        scan_shader.bind_buffer("ScanOutput", block_sums, 1);
+        scan_shader.bind_uniform("scan_pass", 1);
+        scan_shader.bind_uniform("count", num_blocks());
+        scan_shader.dispatch(1, 1, 1);
+        scan_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scan_shader.bind_buffer("ScanOutput", cell_start, 1);
+        scan_shader.bind_uniform("scan_pass", 2);
+        scan_shader.bind_uniform("count", grid_cells);
+        scan_shader.dispatch(num_blocks(), 1, 1);
+        scan_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        scatter_shader.use();
+        scatter_shader.bind_buffer("ParticlesBuffer", particles, 0);
+        scatter_shader.bind_buffer("ParticleCells", particle_cells, 2);
+        scatter_shader.bind_buffer("GridCellStart", cell_start, 3);
+        scatter_shader.bind_buffer("SortedParticlesOutput", sorted_particles, 4);
+        bind_uniforms(scatter_shader);
+        scatter_shader.bind_uniform("num_particles", num_particles);
+        scatter_shader.dispatch(particle_groups, 1, 1);
+        scatter_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    /**
+     * Binds the grid to a shader that has been initialized with shader_prefix(), the shader has to be in use.
+     * @param enabled sets use_grid, if false the shader falls back to looping over all particles
+     * @param first_point first of the three buffer binding points used for the grid
+     */
+    template<typename Shader>
+    void bind(const Shader &shader, bool enabled, int first_point) const {
+        shader.bind_uniform("use_grid", enabled);
+        if (!enabled) return;
+        shader.bind_buffer("GridCellStart", cell_start, first_point);
+        shader.bind_buffer("GridCellCount", cell_count, first_point + 1);
+        shader.bind_buffer("SortedParticlesBuffer", sorted_particles, first_point + 2);
+        bind_uniforms(shader);
+    }
+
+private:
+    // 2 or 3, the particles are stored as described by ParticleLayout
+    int dimension;
+
+    SimpleComputeShader count_shader = SimpleComputeShader("shaders/particle-lenia/grid/grid_count.comp");
+    SimpleComputeShader scan_shader = SimpleComputeShader("shaders/particle-lenia/grid/grid_scan.comp");
+    SimpleComputeShader scatter_shader = SimpleComputeShader("shaders/particle-lenia/grid/grid_scatter.comp");
+
+    // number of blocks of 1024 cells scanned by one workgroup of grid_scan.comp
+    int num_blocks() const {
+        return std::max(grid_cells / 1024, 1);
+    }
+
+    template<typename Shader>
+    void bind_uniforms(const Shader &shader) const {
+        shader.bind_uniform("grid_cell_size", cell_size);
+        shader.bind_uniform("grid_cutoff", cutoff);
+        shader.bind_uniform("grid_cells", grid_cells);
+    }
+};
+
+#endif //PARTICLE_LENIA_PARTICLE_GRID_HPP
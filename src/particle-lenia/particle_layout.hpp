@@ -0,0 +1,49 @@
+#ifndef PARTICLE_LENIA_PARTICLE_LAYOUT_HPP
+#define PARTICLE_LENIA_PARTICLE_LAYOUT_HPP
+
+#include <GLFWAbstraction.h>
+#include <ParticleLeniaCore.h>
+#include <iostream>
+#include <string>
+
+/**
+ * How the particles of one dimension are stored in shader storage buffers, which the shaders declare as
+ * "vecN particles[]" in std430 blocks. 2D particles are packed vec2. std430 pads the elements of vec3 arrays to
+ * 16 bytes, so 3D particles take a vec4 each, whose fourth lane the shaders don't touch.
+ * The layout itself is ParticleLeniaCore::STRIDE (which also packs and unpacks the particles), this is the runtime
+ * view of it for code that handles both dimensions, like ParticleGrid. The sizes of the buffers are stride() floats
+ * per particle.
+ */
+class ParticleLayout {
+public:
+    // 2 or 3 coordinates per particle
+    int dimension;
+
+    explicit ParticleLayout(int dimension) : dimension(dimension) {}
+
+    // floats per particle in a buffer
+    int stride() const {
+        return dimension == 3 ? ParticleLeniaCore<3, float>::STRIDE : ParticleLeniaCore<2, float>::STRIDE;
+    }
+
+    // bytes per particle in a buffer, the array stride the shaders have to use
+    int bytes() const {
+        return stride() * (int) sizeof(float);
+    }
+
+    /**
+     * Compares the array stride the linked shader uses for a particle block with this layout.
+     * Blocks the shader doesn't use are skipped.
+     * @return false (after printing the difference) if the shader would read the particles misaligned
+     */
+    template<typename Shader>
+    bool validate(const Shader &shader, const std::string &block) const {
+        GLint shader_stride = shader.find_block_array_stride(block);
+        if (shader_stride == 0 || shader_stride == bytes()) return true;
+        std::cerr << "particle layout mismatch in " << block << ": the shader uses " << shader_stride
+                  << " bytes per particle, the buffers " << bytes() << std::endl;
+        return false;
+    }
+};
+
+#endif //PARTICLE_LENIA_PARTICLE_LAYOUT_HPP
@@ -1,9 +1,19 @@
+#include <algorithm>
 #include <cmath>
 #include <GLFWAbstraction.h>
 #include <random>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <ParticleLeniaCore.h>
+#include <ParticleMesh.h>
 
-class ParticleLenia2D {
+#include "lenia_params.hpp"
+#include "particle_grid.hpp"
+#include "particle_layout.hpp"
+#include "shader_variants.hpp"
+
+class ParticleLenia2D : public ParticleLeniaCore<2, float> {
 public:
     float internal_width = 30;
     float internal_height = 30;
@@ -11,30 +21,19 @@ public:
     int view_width = 900;
     int view_height = 900;
 
-    // parameters for the kernel
-    float w_k = 0.022;
-    float mu_k = 4.0;
-    // sigma k squared
-    float sigma_k2 = 1.0;
-
-    // parameters for the growth field
-    float mu_g = 0.6;
-    // sigma g squared
-    float sigma_g2 = std::pow(0.15f, 2.0f);
+    // invocations per workgroup of particle.comp and particles per tile it shares through shared memory,
+    // both are compiled into the shader, so they have to be set before init() or compile_step_shader()
+    int local_size = 128;
+    int tile_size = 128;
 
-    // factor used to scale repulsion
-    float c_rep = 1.0;
-    // minimum distance to particle for repulsion
-    float r_distance = 1e-10;
+    // bin the particles into a grid on the gpu every step, so fields only sum up particles within the cutoff radius
+    bool use_grid = false;
 
-    // number of particles
-    int num_particles = 300;
+    // use copies of the shaders with the current parameters and render modes compiled in, once they stopped changing
+    bool specialize = false;
 
-    // value for gradient calculations
-    float h = 0.01;
-    float h2 = 2 * h;
-    // time step size
-    float dt = 0.1;
+    // shade the field background from a particle mesh built on the cpu instead of summing up all particles per pixel
+    bool use_particle_mesh = false;
 
     // colors
     ImVec4 background_color = ImVec4(1 / 255., 23 / 255., 47 / 255., 1.0);
@@ -47,13 +46,44 @@ public:
     float translate_y = 0;
 
     bool is_particles_a = true;
+    // number of particles in the buffers, num_particles differs from it until resize_buffer() is called
+    int stored_particles = 0;
 
-    Buffer particles_a = Buffer(num_particles * 2, GL_SHADER_STORAGE_BUFFER);
-    Buffer particles_b = Buffer(num_particles * 2, GL_SHADER_STORAGE_BUFFER);
+    Buffer particles_a = Buffer(num_particles * 2, GL_SHADER_STORAGE_BUFFER, true);
+    Buffer particles_b = Buffer(num_particles * 2, GL_SHADER_STORAGE_BUFFER, true);
 
     FragmentOnlyShader info_shader = FragmentOnlyShader("shaders/particle-lenia/2d/fields_2d.generated.frag");
     SimpleComputeShader particle_step = SimpleComputeShader("shaders/particle-lenia/2d/particle_2d.generated.comp");
 
+    ShaderVariants2D variants = ShaderVariants2D("shaders/particle-lenia/2d/fields_2d.generated.frag",
+                                                 "shaders/particle-lenia/2d/particle_2d.generated.comp");
+    // variant used this frame, nullptr while the generic shaders are used
+    ShaderVariants2D::Variant *variant = nullptr;
+
+    ParticleGrid grid = ParticleGrid(DIMENSION);
+    LeniaParamsBuffer params_buffer;
+
+    // called with the particles after every step if set, they are copied asynchronously and arrive a frame or two
+    // later (in order), so the simulation doesn't wait for them
+    std::function<void(long step, const float *particles, int num_particles)> on_step;
+    // the steps of a batch are copied into one staging buffer, delivered as soon as the next batch starts
+    ReadbackRing step_readback = ReadbackRing(2);
+    // number of steps since the start
+    long step_count = 0;
+
+    // cpu time it took to submit one step of the last batch, without waiting for the previous batch
+    double submit_microseconds_per_step = 0;
+    // signaled when the gpu finished the last batch of steps
+    GLsync batch_fence = nullptr;
+
+    ParticleMesh particle_mesh;
+    // positions of the particles the mesh is built from, kept to avoid allocating every frame
+    std::vector<float> xs, ys;
+    // one worker per hardware thread, only started once the mesh is built for the first time
+    std::unique_ptr<ThreadPool> mesh_pool;
+    // U, dU/dx, dU/dy and R at the mesh points
+    Texture mesh_texture = Texture(particle_mesh.mesh_size, particle_mesh.mesh_size, GL_RGBA32F, GL_FLOAT, GL_RGBA);
+
     void init() {
         std::cout << "HI\n";
         particles_a.init();
@@ -62,67 +92,112 @@ public:
         // generate random particles
         reset_particles();
 
-        info_shader.init_without_arguments();
-        particle_step.init_without_arguments();
+        grid.init(num_particles);
+        params_buffer.init();
+        mesh_texture.init();
+        info_shader.init(grid.shader_prefix());
+        compile_step_shader();
+        ParticleLayout(DIMENSION).validate(info_shader, "ParticlesBuffer");
+    }
+
+    // (re)compiles particle.comp for the current local_size and tile_size
+    void compile_step_shader() {
+        particle_step.init(step_shader_arguments());
+        ParticleLayout(DIMENSION).validate(particle_step, "ParticlesBuffer");
+        ParticleLayout(DIMENSION).validate(particle_step, "ParticlesBufferUpdated");
     }
 
+    std::string step_shader_arguments() const {
+        return grid.shader_prefix() + generate_arguments(Argument<int>{"LOCAL_SIZE", local_size},
+                                                         Argument<int>{"TILE_SIZE", tile_size});
+    }
+
+    // arguments that compile the current parameters (except num_particles) and render modes into the shaders
+    std::string specialization_arguments() const {
+        return "#define SPECIALIZED\n" +
+               generate_arguments(Argument<float>{"SPECIALIZED_W_K", w_k}, Argument<float>{"SPECIALIZED_MU_K", mu_k},
+                                  Argument<float>{"SPECIALIZED_SIGMA_K2", sigma_k2},
+                                  Argument<float>{"SPECIALIZED_MU_G", mu_g},
+                                  Argument<float>{"SPECIALIZED_SIGMA_G2", sigma_g2},
+                                  Argument<float>{"SPECIALIZED_C_REP", c_rep},
+                                  Argument<float>{"SPECIALIZED_R_DISTANCE", r_distance},
+                                  Argument<float>{"SPECIALIZED_H", h}, Argument<float>{"SPECIALIZED_H2", h2},
+                                  Argument<float>{"SPECIALIZED_DT", dt},
+                                  Argument<bool>{"SPECIALIZED_ANALYTIC_GRADIENT", analytic_gradient},
+                                  Argument<int>{"SPECIALIZED_RENDER_1", render_1},
+                                  Argument<int>{"SPECIALIZED_RENDER_2", render_2});
+    }
+
+    // picks the specialized variant for the current parameters if it is ready, the generic shaders otherwise
+    void select_shaders() {
+        variant = specialize ? variants.select(specialization_arguments(), grid.shader_prefix(),
+                                               step_shader_arguments()) : nullptr;
+    }
 
     void reset_particles() {
+        reserve(num_particles);
         std::random_device dev;
         std::mt19937 rng(dev());
-        std::uniform_real_distribution<> distribution(-((double) internal_width) * 0.3,
-                                                      ((double) internal_width) * 0.3);
-        std::vector<float> particles;
-        for (int i = 0; i < 2 * num_particles; ++i) {
-            particles.emplace_back(distribution(rng));
-        }
+        std::vector<float> particles = pack(random_particles(num_particles, internal_width * 0.3, rng));
         particles_a.set_data(particles);
         particles_b.set_data(particles);
+        stored_particles = num_particles;
+    }
+
+    // number of particles the buffers have room for
+    int capacity() const {
+        return particles_a.size / 2;
+    }
+
+    /**
+     * Makes room for at least the given number of particles. The capacity at least doubles, so adding particles one
+     * at a time only reallocates log(N) times, and the particles are copied on the gpu.
+     */
+    void reserve(int particles) {
+        if (particles <= capacity()) return;
+        int grown = std::max(particles, 2 * capacity());
+        particles_a.grow(2 * grown);
+        particles_b.grow(2 * grown);
     }
 
+    // adds particles at the given positions (x, y pairs) behind the current ones, only the new ones are uploaded
+    void append_particles(const std::vector<float> &positions) {
+        int added = (int) positions.size() / 2;
+        reserve(stored_particles + added);
+        // the step writes every particle of the other buffer, but display and the grid read the current one
+        particles_a.set_sub_data(2 * stored_particles, positions.data(), 2 * added);
+        particles_b.set_sub_data(2 * stored_particles, positions.data(), 2 * added);
+        stored_particles += added;
+        num_particles = stored_particles;
+        grid.resize(num_particles);
+    }
+
+    /**
+     * Adapts the buffers to a changed num_particles. Fewer particles only lower the count, the removed ones stay in
+     * the buffers. More particles are appended, randomly or at the position append.
+     * @param reset replaces all particles with random ones
+     */
     void resize_buffer(bool reset, bool append_random = true, ImVec2 append = {0, 0}) {
-        std::vector<float> data;
         if (reset) {
-            std::random_device dev;
-            std::mt19937 rng(dev());
-            std::uniform_real_distribution<> distribution(-((double) internal_width) * 0.3,
-                                                          ((double) internal_width) * 0.3);
-            for (int i = 0; i < 2 * num_particles; ++i) {
-                data.emplace_back(distribution(rng));
-            }
-        } else {
-            data = particles_a.get_data();
-
-            // create more data if necessary
-            if (data.size() < num_particles * 2) {
-                if (append_random) {
-                    std::random_device dev;
-                    std::mt19937 rng(dev());
-                    std::uniform_real_distribution<> distribution(-((double) internal_width) * 0.3,
-                                                                  ((double) internal_width) * 0.3);
-                    while (data.size() < num_particles * 2) data.push_back(distribution(rng));
-                } else {
-                    while (data.size() < num_particles * 2) {
-                        data.push_back(append.x);
-                        data.push_back(append.y);
-                    }
-                }
+            reset_particles();
+        } else if (num_particles > stored_particles) {
+            std::vector<float> data;
+            if (append_random) {
+                std::random_device dev;
+                std::mt19937 rng(dev());
+                data = pack(random_particles(num_particles - stored_particles, internal_width * 0.3, rng));
             } else {
-                data.resize(2 * num_particles);
+                for (int i = stored_particles; i < num_particles; ++i) {
+                    data.push_back(append.x);
+                    data.push_back(append.y);
+                }
             }
+            append_particles(data);
+        } else {
+            stored_particles = num_particles;
         }
 
-        particles_a.delete_buffer();
-        particles_b.delete_buffer();
-
-        particles_a = Buffer(2 * num_particles, GL_SHADER_STORAGE_BUFFER);
-        particles_b = Buffer(2 * num_particles, GL_SHADER_STORAGE_BUFFER);
-
-        particles_a.init();
-        particles_b.init();
-
-        particles_a.set_data(data);
-        particles_b.set_data(data);
+        grid.resize(num_particles);
     }
 
 
@@ -146,74 +221,128 @@ public:
         return position;
     }
 
+    // sorts the current particles into the grid
+    void build_grid() {
+        grid.cutoff = cutoff_radius();
+        // the central difference positions may lie up to h outside of the cell of their particle
+        grid.cell_size = grid.cutoff + (analytic_gradient ? 0.0f : h);
+        grid.build(is_particles_a ? particles_a : particles_b, num_particles);
+    }
+
+    // downloads the current particles and convolves them on the mesh
+    void build_particle_mesh() {
+        const Buffer &particles = is_particles_a ? particles_a : particles_b;
+        // read straight from the persistent mapping, without an intermediate copy
+        particles.sync();
+        const float *data = particles.mapped_data();
+        xs.resize(num_particles);
+        ys.resize(num_particles);
+        for (int i = 0; i < num_particles; ++i) {
+            xs[i] = data[2 * i];
+            ys[i] = data[2 * i + 1];
+        }
+        if (!mesh_pool) mesh_pool.reset(new ThreadPool(0));
+        particle_mesh.build(field_parameters(), cutoff_radius(), xs.data(), ys.data(),
+                            num_particles, mesh_pool.get());
+        mesh_texture.set_data(particle_mesh.mesh_fields().data());
+    }
+
+    /**
+     * Runs steps_per_frame steps as one batch: the program, the parameters and the block bindings are set once, every
+     * step then only binds the ping-pong pair of buffers, dispatches and waits for shader storage writes.
+     * Without the grid no other state changes between the steps.
+     */
     void step(int steps_per_frame) {
+        // keeps at most one batch in flight, the driver would otherwise queue up frames when the gpu falls behind
+        wait_for_batch();
+        step_readback.poll();
+        auto start = std::chrono::steady_clock::now();
+        select_shaders();
+        SimpleComputeShader &step_shader = variant ? variant->particle_step : particle_step;
+
+        params_buffer.update(lenia_params(*this));
+        params_buffer.bind(step_shader);
+        step_shader.bind_buffer("ParticlesBuffer", particles_a, 0);
+        step_shader.bind_buffer("ParticlesBufferUpdated", particles_b, 1);
+        // buffers bound to (ParticlesBuffer, ParticlesBufferUpdated) when the current particles are in a / in b
+        const GLuint ping_pong[2][2] = {{particles_a.id, particles_b.id},
+                                        {particles_b.id, particles_a.id}};
+        const GLuint groups = (num_particles + local_size - 1) / local_size;
+
+        step_shader.use();
+        grid.bind(step_shader, use_grid, 2);
+        if (on_step) step_readback.begin_batch(steps_per_frame, 2 * num_particles);
         for (int i = 0; i < steps_per_frame; ++i) {
-            if (is_particles_a) {
-                particle_step.bind_buffer("ParticlesBuffer", particles_a, 0);
-                particle_step.bind_buffer("ParticlesBufferUpdated", particles_b, 1);
-            } else {
-                particle_step.bind_buffer("ParticlesBuffer", particles_b, 0);
-                particle_step.bind_buffer("ParticlesBufferUpdated", particles_a, 1);
+            if (use_grid) {
+                // the grid shaders use the same binding points, so everything has to be bound again
+                build_grid();
+                step_shader.use();
+                grid.bind(step_shader, true, 2);
             }
+            glBindBuffersBase(GL_SHADER_STORAGE_BUFFER, 0, 2, ping_pong[is_particles_a ? 0 : 1]);
             is_particles_a = !is_particles_a;
 
-            particle_step.use();
-
-            particle_step.bind_uniform("view_width", (float) view_width);
-            particle_step.bind_uniform("view_height", (float) view_height);
-            particle_step.bind_uniform("internal_width", (float) internal_width);
-            particle_step.bind_uniform("internal_height", (float) internal_height);
-            particle_step.bind_uniform("w_k", w_k);
-            particle_step.bind_uniform("mu_k", mu_k);
-            particle_step.bind_uniform("sigma_k2", sigma_k2);
-            particle_step.bind_uniform("mu_g", mu_g);
-            particle_step.bind_uniform("sigma_g2", sigma_g2);
-            particle_step.bind_uniform("c_rep", c_rep);
-            particle_step.bind_uniform("r_distance", r_distance);
-            particle_step.bind_uniform("num_particles", num_particles);
-            particle_step.bind_uniform("h", h);
-            particle_step.bind_uniform("h2", h2);
-            particle_step.bind_uniform("dt", dt);
-            particle_step.bind_uniform("translate_x", translate_x);
-            particle_step.bind_uniform("translate_y", translate_y);
-
-            particle_step.dispatch(num_particles, 1, 1);
-            particle_step.wait();
+            step_shader.dispatch(groups, 1, 1);
+            // reading the particles back on the cpu goes through Buffer::sync, which adds the barrier it needs
+            step_shader.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            long step = ++step_count;
+            if (on_step) {
+                const Buffer &particles = is_particles_a ? particles_a : particles_b;
+                step_readback.request(particles, [this, step](const float *data, int size) {
+                    on_step(step, data, size / 2);
+                }, 2 * num_particles);
+            }
         }
+        step_readback.end_batch();
+        batch_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        std::chrono::duration<double, std::micro> submit_time = std::chrono::steady_clock::now() - start;
+        submit_microseconds_per_step = steps_per_frame > 0 ? submit_time.count() / steps_per_frame : 0;
+    }
+
+    // blocks until the gpu finished the last batch of steps
+    void wait_for_batch() {
+        if (batch_fence == nullptr) return;
+        while (glClientWaitSync(batch_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(batch_fence);
+        batch_fence = nullptr;
     }
 
     void display() {
+        select_shaders();
+        FragmentOnlyShader &shader = variant ? variant->info_shader : info_shader;
+        if (use_grid) build_grid();
+        if (use_particle_mesh) build_particle_mesh();
+
         if (is_particles_a) {
-            info_shader.bind_buffer("ParticlesBuffer", particles_a, 0);
+            shader.bind_buffer("ParticlesBuffer", particles_a, 0);
         } else {
-            info_shader.bind_buffer("ParticlesBuffer", particles_b, 0);
+            shader.bind_buffer("ParticlesBuffer", particles_b, 0);
         }
 
-        info_shader.use();
-        info_shader.bind_uniform("view_width", (float) view_width);
-        info_shader.bind_uniform("view_height", (float) view_height);
-        info_shader.bind_uniform("internal_width", (float) internal_width);
-        info_shader.bind_uniform("internal_height", (float) internal_height);
-        info_shader.bind_uniform("w_k", w_k);
-        info_shader.bind_uniform("mu_k", mu_k);
-        info_shader.bind_uniform("sigma_k2", sigma_k2);
-        info_shader.bind_uniform("mu_g", mu_g);
-        info_shader.bind_uniform("sigma_g2", sigma_g2);
-        info_shader.bind_uniform("c_rep", c_rep);
-        info_shader.bind_uniform("r_distance", r_distance);
-        info_shader.bind_uniform("num_particles", num_particles);
-        info_shader.bind_uniform("h", h);
-        info_shader.bind_uniform("h2", h2);
-        info_shader.bind_uniform("dt", dt);
-        info_shader.bind_uniform("render_1", render_1);
-        info_shader.bind_uniform("render_2", render_2);
-        info_shader.bind_uniform("background_color",
-                                 std::array<float, 4>{background_color.x, background_color.y, background_color.z,
-                                                      background_color.w});
-        info_shader.bind_uniform("color1", std::array<float, 4>{color_1.x, color_1.y, color_1.z, color_1.w});
-        info_shader.bind_uniform("color2", std::array<float, 4>{color_2.x, color_2.y, color_2.z, color_2.w});
-        info_shader.bind_uniform("translate_x", translate_x);
-        info_shader.bind_uniform("translate_y", translate_y);
-        info_shader.render_to_window();
+        shader.use();
+        grid.bind(shader, use_grid, 2);
+        params_buffer.update(lenia_params(*this));
+        params_buffer.bind(shader);
+        shader.bind_uniform("view_width", (float) view_width);
+        shader.bind_uniform("view_height", (float) view_height);
+        shader.bind_uniform("internal_width", (float) internal_width);
+        shader.bind_uniform("internal_height", (float) internal_height);
+        shader.bind_uniform("render_1", render_1);
+        shader.bind_uniform("render_2", render_2);
+        shader.bind_uniform("background_color",
+                            std::array<float, 4>{background_color.x, background_color.y, background_color.z,
+                                                 background_color.w});
+        shader.bind_uniform("color1", std::array<float, 4>{color_1.x, color_1.y, color_1.z, color_1.w});
+        shader.bind_uniform("color2", std::array<float, 4>{color_2.x, color_2.y, color_2.z, color_2.w});
+        shader.bind_uniform("translate_x", translate_x);
+        shader.bind_uniform("translate_y", translate_y);
+        shader.bind_uniform("use_mesh", use_particle_mesh);
+        shader.bind_uniform("mesh_fields", mesh_texture, 0);
+        shader.bind_uniform("mesh_origin_x", particle_mesh.origin_x);
+        shader.bind_uniform("mesh_origin_y", particle_mesh.origin_y);
+        shader.bind_uniform("mesh_spacing", particle_mesh.spacing);
+        shader.render_to_window();
     }
 };
@@ -0,0 +1,326 @@
+#ifndef PARTICLE_LENIA_PARTICLE_LENIA_3D_HPP
+#define PARTICLE_LENIA_PARTICLE_LENIA_3D_HPP
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <GLFWAbstraction.h>
+#include <imgui/imgui.h>
+#include <ParticleLeniaCore.h>
+
+#include "field_volume.hpp"
+#include "iso_surface.hpp"
+#include "lenia_params.hpp"
+#include "particle_grid.hpp"
+#include "particle_layout.hpp"
+
+/**
+ * 3D version of ParticleLenia2D: particle.comp moves the particles, particle_3d.vert only draws them and
+ * fields_3d.frag shows the fields on the slice at depth. With show_volume, volume_3d.frag raymarches the fields
+ * sampled into the FieldVolume instead, which is only evaluated again once the particles moved. show_surface adds the
+ * IsoSurface extracted from the same volume.
+ * Steps and frames are independent, so the simulation rate is steps_per_frame times the frame rate and not stepping
+ * costs nothing.
+ */
+class ParticleLenia3D : public ParticleLeniaCore<3, float> {
+public:
+    int view_width = 900;
+    int view_height = 900;
+
+    // invocations per workgroup of particle.comp and particles per tile it shares through shared memory,
+    // both are compiled into the shader, so they have to be set before init() or compile_step_shader()
+    int local_size = 128;
+    int tile_size = 128;
+
+    // bin the particles into a grid on the gpu every step, so fields only sum up particles within the cutoff radius
+    bool use_grid = false;
+
+    // colors
+    ImVec4 background_color = ImVec4(1 / 255., 23 / 255., 47 / 255., 1.0);
+    ImVec4 color_1 = ImVec4(46 / 255., 134 / 255., 171 / 255., 1.0);
+    ImVec4 color_2 = ImVec4(241.0 / 255., 143.0 / 255., 1.0 / 255., 1.0);
+    int render_1 = 1;
+    int render_2 = 3;
+    // position of the slice the fields are shown on
+    float depth = 3.;
+
+    // maps the values of a field to the opacity of the volume: transparent below low, fully covered from high on
+    struct TransferFunction {
+        float low;
+        float high;
+        // opacity per unit length of fully covered samples
+        float opacity;
+    };
+
+    // raymarch the whole volume of the fields instead of showing a slice
+    bool show_volume = false;
+    // transfer functions of render_1 and render_2
+    TransferFunction transfer_1{0.1f, 0.6f, 0.3f};
+    TransferFunction transfer_2{0.5f, 1.0f, 0.3f};
+    // samples along a ray through the whole volume
+    int ray_steps = 128;
+    // draw the surface of surface.field == surface.iso, extracted from the volume
+    bool show_surface = false;
+
+    // view transformation
+    std::array<float, 3> scale{1. / 10, 1. / 10, 1. / 10};
+    std::array<float, 9> rotate{
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1
+    };
+    std::array<float, 3> translate{0, 0, 0};
+
+    bool is_particles_a = true;
+    // changes whenever the particles in the buffers change, tells the volume when it has to be evaluated again
+    long particles_version = 0;
+
+    // vec4 per particle, the buffers hold STRIDE floats per particle, the shaders are checked against it
+    ParticleLayout layout = ParticleLayout(DIMENSION);
+    Buffer particles_a = Buffer(num_particles * STRIDE, GL_SHADER_STORAGE_BUFFER, true);
+    Buffer particles_b = Buffer(num_particles * STRIDE, GL_SHADER_STORAGE_BUFFER, true);
+
+    SimpleShader point_shader = SimpleShader("shaders/particle-lenia/3d/particle_3d.generated.vert",
+                                             "shaders/particle-lenia/3d/particle_3d.frag");
+    FragmentOnlyShader info_shader = FragmentOnlyShader("shaders/particle-lenia/3d/fields_3d.generated.frag");
+    SimpleComputeShader particle_step = SimpleComputeShader("shaders/particle-lenia/3d/particle_3d.generated.comp");
+
+    ParticleGrid grid = ParticleGrid(DIMENSION);
+    LeniaParamsBuffer params_buffer;
+
+    FieldVolume volume;
+    IsoSurface surface;
+    FragmentOnlyShader volume_shader = FragmentOnlyShader("shaders/particle-lenia/3d/volume_3d.frag");
+
+    // cpu time it took to submit one step of the last batch, without waiting for the previous batch
+    double submit_microseconds_per_step = 0;
+    // signaled when the gpu finished the last batch of steps
+    GLsync batch_fence = nullptr;
+
+    // the points have no attributes, the vertex shader reads them from the particle buffer
+    unsigned int VAO = 0;
+
+    void init() {
+        particles_a.init();
+        particles_b.init();
+
+        // generate random particles
+        reset_particles();
+
+        grid.init(num_particles);
+        params_buffer.init();
+        point_shader.init(grid.shader_prefix());
+        info_shader.init(grid.shader_prefix());
+        compile_step_shader();
+        volume.init(grid.shader_prefix());
+        volume_shader.init_without_arguments();
+        surface.init();
+        layout.validate(point_shader, "ParticlesBuffer");
+        layout.validate(info_shader, "ParticlesBuffer");
+
+        glGenVertexArrays(1, &VAO);
+    }
+
+    // (re)compiles particle.comp for the current local_size and tile_size
+    void compile_step_shader() {
+        particle_step.init(grid.shader_prefix() + generate_arguments(Argument<int>{"LOCAL_SIZE", local_size},
+                                                                     Argument<int>{"TILE_SIZE", tile_size}));
+        layout.validate(particle_step, "ParticlesBuffer");
+        layout.validate(particle_step, "ParticlesBufferUpdated");
+    }
+
+    void reset_particles() {
+        std::random_device dev;
+        std::mt19937 rng(dev());
+        std::vector<float> particles = pack(random_particles(num_particles, 10, rng));
+        particles_a.set_data(particles);
+        particles_b.set_data(particles);
+        ++particles_version;
+    }
+
+    /**
+     * Adapts the buffers to a changed num_particles. Fewer particles drop the last ones, more particles are appended,
+     * randomly or at the position append (on the plane z = 0).
+     * @param reset replaces all particles with random ones
+     */
+    void resize_buffer(bool reset, bool append_random = true, ImVec2 append = {0, 0}) {
+        std::random_device dev;
+        std::mt19937 rng(dev());
+        std::vector<Vector> kept;
+        if (!reset) {
+            const Buffer &particles = is_particles_a ? particles_a : particles_b;
+            kept = unpack(particles.get_data(), std::min(num_particles, particles.size / STRIDE));
+        }
+        // create more particles if necessary
+        int missing = num_particles - (int) kept.size();
+        std::vector<Vector> added(missing, Vector{append.x, append.y, 0});
+        if (append_random || reset) added = random_particles(missing, 10, rng);
+        kept.insert(kept.end(), added.begin(), added.end());
+        std::vector<float> data = pack(kept);
+
+        particles_a = Buffer(STRIDE * num_particles, GL_SHADER_STORAGE_BUFFER, true);
+        particles_b = Buffer(STRIDE * num_particles, GL_SHADER_STORAGE_BUFFER, true);
+
+        particles_a.init();
+        particles_b.init();
+
+        particles_a.set_data(data);
+        particles_b.set_data(data);
+        ++particles_version;
+
+        grid.resize(num_particles);
+    }
+
+    // sorts the current particles into the grid
+    void build_grid() {
+        grid.cutoff = cutoff_radius();
+        // the central difference positions may lie up to h outside of the cell of their particle
+        grid.cell_size = grid.cutoff + (analytic_gradient ? 0.0f : h);
+        grid.build(is_particles_a ? particles_a : particles_b, num_particles);
+    }
+
+    // runs steps_per_frame steps as one batch, like ParticleLenia2D::step
+    void step(int steps_per_frame) {
+        // keeps at most one batch in flight, the driver would otherwise queue up frames when the gpu falls behind
+        wait_for_batch();
+        auto start = std::chrono::steady_clock::now();
+
+        params_buffer.update(lenia_params(*this));
+        params_buffer.bind(particle_step);
+        particle_step.bind_buffer("ParticlesBuffer", particles_a, 0);
+        particle_step.bind_buffer("ParticlesBufferUpdated", particles_b, 1);
+        // buffers bound to (ParticlesBuffer, ParticlesBufferUpdated) when the current particles are in a / in b
+        const GLuint ping_pong[2][2] = {{particles_a.id, particles_b.id},
+                                        {particles_b.id, particles_a.id}};
+        const GLuint groups = (num_particles + local_size - 1) / local_size;
+
+        particle_step.use();
+        grid.bind(particle_step, use_grid, 2);
+        for (int i = 0; i < steps_per_frame; ++i) {
+            if (use_grid) {
+                // the grid shaders use the same binding points, so everything has to be bound again
+                build_grid();
+                particle_step.use();
+                grid.bind(particle_step, true, 2);
+            }
+            glBindBuffersBase(GL_SHADER_STORAGE_BUFFER, 0, 2, ping_pong[is_particles_a ? 0 : 1]);
+            is_particles_a = !is_particles_a;
+
+            particle_step.dispatch(groups, 1, 1);
+            // reading the particles back on the cpu goes through Buffer::sync, which adds the barrier it needs
+            particle_step.wait(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        batch_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (steps_per_frame > 0) ++particles_version;
+
+        std::chrono::duration<double, std::micro> submit_time = std::chrono::steady_clock::now() - start;
+        submit_microseconds_per_step = steps_per_frame > 0 ? submit_time.count() / steps_per_frame : 0;
+    }
+
+    // blocks until the gpu finished the last batch of steps
+    void wait_for_batch() {
+        if (batch_fence == nullptr) return;
+        while (glClientWaitSync(batch_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {}
+        glDeleteSync(batch_fence);
+        batch_fence = nullptr;
+    }
+
+    /**
+     * Samples the fields into the volume, unless it holds the fields of the current particles already.
+     * Stepping changes the particles once per batch, so this evaluates the fields at most once per frame and not at
+     * all while the simulation is paused.
+     */
+    void update_volume() {
+        LeniaParams params = lenia_params(*this);
+        if (volume.current(particles_version, params, use_grid, cutoff_radius())) return;
+        if (use_grid) build_grid();
+        params_buffer.update(params);
+        volume.evaluate(is_particles_a ? particles_a : particles_b, particles_version, grid, use_grid, params_buffer,
+                        params);
+    }
+
+    // draws the fields (on the slice at depth, or the whole volume with show_volume), the surface with show_surface and
+    // the particles on top
+    void display() {
+        const Buffer &particles = is_particles_a ? particles_a : particles_b;
+        if (show_volume) {
+            display_volume();
+        } else {
+            display_slice();
+        }
+        if (show_surface) display_surface();
+
+        point_shader.bind_buffer("ParticlesBuffer", particles, 0);
+        point_shader.use();
+        point_shader.bind_uniform("rotation", rotate);
+        point_shader.bind_uniform("translate", translate);
+        point_shader.bind_uniform("scale", scale);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindVertexArray(VAO);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glDrawArrays(GL_POINTS, 0, num_particles);
+    }
+
+    // shows the fields on the slice at depth, evaluated for every pixel
+    void display_slice() {
+        if (use_grid) build_grid();
+        const Buffer &particles = is_particles_a ? particles_a : particles_b;
+
+        info_shader.bind_buffer("ParticlesBuffer", particles, 0);
+        info_shader.use();
+        grid.bind(info_shader, use_grid, 1);
+        params_buffer.update(lenia_params(*this));
+        params_buffer.bind(info_shader);
+        info_shader.bind_uniform("render_1", render_1);
+        info_shader.bind_uniform("render_2", render_2);
+        info_shader.bind_uniform("background_color",
+                                 std::array<float, 4>{background_color.x, background_color.y, background_color.z,
+                                                      background_color.w});
+        info_shader.bind_uniform("color1", std::array<float, 4>{color_1.x, color_1.y, color_1.z, color_1.w});
+        info_shader.bind_uniform("color2", std::array<float, 4>{color_2.x, color_2.y, color_2.z, color_2.w});
+        info_shader.bind_uniform("rotation", rotate);
+        info_shader.bind_uniform("translate", translate);
+        info_shader.bind_uniform("scale", scale);
+        info_shader.bind_uniform("depth", depth);
+        info_shader.render_to_window();
+    }
+
+    // raymarches the sampled fields, the cost per pixel only depends on ray_steps and not on the number of particles
+    void display_volume() {
+        update_volume();
+
+        volume_shader.use();
+        volume_shader.bind_uniform("field_volume", volume.texture, 0);
+        volume_shader.bind_uniform("volume_origin", volume.origin());
+        volume_shader.bind_uniform("volume_extent", volume.extent);
+        volume_shader.bind_uniform("ray_steps", ray_steps);
+        volume_shader.bind_uniform("render_1", render_1);
+        volume_shader.bind_uniform("render_2", render_2);
+        volume_shader.bind_uniform("low_1", transfer_1.low);
+        volume_shader.bind_uniform("high_1", transfer_1.high);
+        volume_shader.bind_uniform("opacity_1", transfer_1.opacity);
+        volume_shader.bind_uniform("low_2", transfer_2.low);
+        volume_shader.bind_uniform("high_2", transfer_2.high);
+        volume_shader.bind_uniform("opacity_2", transfer_2.opacity);
+        volume_shader.bind_uniform("background_color",
+                                   std::array<float, 4>{background_color.x, background_color.y, background_color.z,
+                                                        background_color.w});
+        volume_shader.bind_uniform("color1", std::array<float, 4>{color_1.x, color_1.y, color_1.z, color_1.w});
+        volume_shader.bind_uniform("color2", std::array<float, 4>{color_2.x, color_2.y, color_2.z, color_2.w});
+        volume_shader.bind_uniform("rotation", rotate);
+        volume_shader.bind_uniform("translate", translate);
+        volume_shader.bind_uniform("scale", scale);
+        volume_shader.render_to_window();
+    }
+
+    // extracts the surface again if the volume or its settings changed, and draws it
+    void display_surface() {
+        update_volume();
+        if (!surface.current(volume)) surface.extract(volume);
+        surface.draw(rotate, translate, scale);
+    }
+};
+
+#endif //PARTICLE_LENIA_PARTICLE_LENIA_3D_HPP
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <ParticleLenia2DCpu.h>
+#include <ParticleMesh.h>
+
+// reports the error of the particle mesh against the exact fields and the seconds per step for several mesh sizes
+// usage: particle_mesh_report [num_particles] [mu_k] [threads] [particles per unit area]
+int main(int argc, char **argv) {
+    int num_particles = argc > 1 ? std::atoi(argv[1]) : 20000;
+    float mu_k = argc > 2 ? (float) std::atof(argv[2]) : 4.0f;
+    int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+    // defaults to the density of the default 300 particles in a 30 x 30 area (they are placed in the middle 60%)
+    float density = argc > 4 ? (float) std::atof(argv[4]) : 300 / (18.0f * 18.0f);
+
+    const std::vector<int> mesh_sizes{64, 128, 256, 512, 1024};
+    const int samples = 1000;
+
+    ParticleLenia2DCpu particle_lenia(threads);
+    particle_lenia.mu_k = mu_k;
+    particle_lenia.num_particles = num_particles;
+    particle_lenia.reset_particles(std::sqrt(num_particles / density) / 0.6f, 0);
+    const std::vector<float> initial = particle_lenia.get_particles();
+    // stepping moves the particles of the engine, the mesh is always built from these
+    const std::vector<float> xs = particle_lenia.x;
+    const std::vector<float> ys = particle_lenia.y;
+    const FieldParameters parameters = particle_lenia.field_parameters();
+    ThreadPool pool(threads);
+
+    // exact fields at the first particles
+    const int count = std::min(samples, num_particles);
+    std::vector<FieldSums> exact(count);
+    field_kernel_scalar(parameters, xs.data(), ys.data(), num_particles, xs.data(), ys.data(), count, exact.data());
+    double mean_u = 0.0;
+    for (const FieldSums &sums: exact) mean_u += sums.u / count;
+
+    auto seconds_per_step = [&](NeighbourSearch search) {
+        particle_lenia.neighbour_search = search;
+        particle_lenia.set_particles(initial);
+        auto start = std::chrono::steady_clock::now();
+        particle_lenia.step(1);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::printf("%d particles, %.2f per unit area, mu_k = %.2f, errors of U relative to the mean of U, "
+                "gradient errors absolute\n", num_particles, density, mu_k);
+    std::printf("cell list: %.4f s per step\n", seconds_per_step(NeighbourSearch::CELL_LIST));
+    std::printf("%10s %10s %14s %14s %16s %12s %12s\n", "mesh size", "spacing", "max U error", "rms U error",
+                "max grad error", "mesh build", "s per step");
+    for (int mesh_size: mesh_sizes) {
+        ParticleMesh mesh;
+        mesh.mesh_size = mesh_size;
+        auto start = std::chrono::steady_clock::now();
+        mesh.build(parameters, particle_lenia.cutoff_radius(), xs.data(), ys.data(), num_particles, &pool);
+        double build = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double max_error = 0.0, squared_error = 0.0, max_gradient_error = 0.0;
+        for (int i = 0; i < count; ++i) {
+            FieldSums sums = mesh.sample(xs[i], ys[i]);
+            double error = std::fabs(sums.u - exact[i].u);
+            max_error = std::max(max_error, error);
+            squared_error += error * error;
+            max_gradient_error = std::max(max_gradient_error, (double) std::hypot(sums.grad_u_x - exact[i].grad_u_x,
+                                                                                  sums.grad_u_y - exact[i].grad_u_y));
+        }
+
+        particle_lenia.mesh_size = mesh_size;
+        double step = seconds_per_step(NeighbourSearch::PARTICLE_MESH);
+        std::printf("%10d %10.3f %14.3e %14.3e %16.3e %12.4f %12.4f\n", mesh_size, mesh.spacing, max_error / mean_u,
+                    std::sqrt(squared_error / count) / mean_u, max_gradient_error, build, step);
+    }
+}
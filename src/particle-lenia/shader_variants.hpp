@@ -0,0 +1,109 @@
+#ifndef PARTICLE_LENIA_SHADER_VARIANTS_HPP
+#define PARTICLE_LENIA_SHADER_VARIANTS_HPP
+
+#include <GLFWAbstraction.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Copies of the field and step shader of ParticleLenia2D with the parameters and render modes compiled in as
+ * constants (SPECIALIZED in fields_functions.glsl), so the driver can fold them into the kernel and growth
+ * functions and drop the branches that aren't taken.
+ * Variants are cached by their arguments. A new one is only built once the arguments stayed the same for
+ * settle_seconds, so dragging a slider doesn't compile a program per frame, and it is compiled in the background
+ * (see SimpleShader::start_init). Until it is ready, select() returns nullptr and the generic shaders are used.
+ */
+class ShaderVariants2D {
+public:
+    struct Variant {
+        FragmentOnlyShader info_shader;
+        SimpleComputeShader particle_step;
+        // finish_init() has been called on both shaders
+        bool ready = false;
+        // last call of select() that returned or started the variant
+        long last_used = 0;
+
+        Variant(const char *info_path, const char *step_path) : info_shader(info_path), particle_step(step_path) {}
+    };
+
+    // time the arguments have to stay the same before a variant is built for them
+    float settle_seconds = 0.5;
+    // the least recently used variant is deleted when a new one would exceed this
+    int max_variants = 16;
+    // number of variants built so far
+    int built = 0;
+
+    ShaderVariants2D(const char *info_path, const char *step_path) : info_path(info_path), step_path(step_path) {}
+
+    /**
+     * Returns the variant for the arguments, starts building it once they settled. Has to be called every frame
+     * while variants are used, that is where finished variants are picked up.
+     * @param specialization SPECIALIZED and its values
+     * @param info_arguments, step_arguments the arguments of the generic field and step shader
+     * @return nullptr while there is no variant for the arguments or it is still compiling
+     */
+    Variant *select(const std::string &specialization, const std::string &info_arguments,
+                    const std::string &step_arguments) {
+        ++selections;
+        const std::string key = info_arguments + step_arguments + specialization;
+        const auto now = std::chrono::steady_clock::now();
+        if (key != last_key) {
+            last_key = key;
+            changed_at = now;
+        }
+
+        auto found = variants.find(key);
+        if (found == variants.end()) {
+            if (std::chrono::duration<float>(now - changed_at).count() < settle_seconds) return nullptr;
+            if ((int) variants.size() >= max_variants) evict_least_recently_used();
+            std::unique_ptr<Variant> variant(new Variant(info_path, step_path));
+            variant->info_shader.start_init(info_arguments + specialization);
+            variant->particle_step.start_init(step_arguments + specialization);
+            variant->last_used = selections;
+            ++built;
+            found = variants.emplace(key, std::move(variant)).first;
+        }
+
+        Variant &variant = *found->second;
+        variant.last_used = selections;
+        if (!variant.ready) {
+            if (!variant.info_shader.init_ready() || !variant.particle_step.init_ready()) return nullptr;
+            variant.info_shader.finish_init();
+            variant.particle_step.finish_init();
+            variant.ready = true;
+        }
+        return &variant;
+    }
+
+    // number of cached variants, including the ones still compiling
+    int size() const {
+        return (int) variants.size();
+    }
+
+    // deletes all variants
+    void clear() {
+        variants.clear();
+    }
+
+private:
+    const char *info_path;
+    const char *step_path;
+
+    std::unordered_map<std::string, std::unique_ptr<Variant>> variants;
+    // arguments of the last select() and when they last changed
+    std::string last_key;
+    std::chrono::steady_clock::time_point changed_at = std::chrono::steady_clock::now();
+    long selections = 0;
+
+    void evict_least_recently_used() {
+        auto oldest = variants.begin();
+        for (auto it = variants.begin(); it != variants.end(); ++it) {
+            if (it->second->last_used < oldest->second->last_used) oldest = it;
+        }
+        if (oldest != variants.end()) variants.erase(oldest);
+    }
+};
+
+#endif //PARTICLE_LENIA_SHADER_VARIANTS_HPP
@@ -0,0 +1,104 @@
+#ifndef PARTICLE_LENIA_TUNING_PROFILE_HPP
+#define PARTICLE_LENIA_TUNING_PROFILE_HPP
+
+#include <glad/glad.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// written by autotune and read by the guis, relative to the working directory like the shaders
+const char *const TUNING_PROFILE_PATH = "particle_lenia_profile.txt";
+
+// fastest configuration of the 2D step that autotune found on one device
+struct TuningProfile {
+    // invocations per workgroup and particles per shared memory tile of particle.comp
+    int local_size = 128;
+    int tile_size = 128;
+    // whether the uniform grid was faster than evaluating all pairs
+    bool use_grid = false;
+    // number of particles the configurations were measured with
+    int num_particles = 0;
+};
+
+// identifies the device and the driver of the current OpenGL context, profiles are stored per key
+inline std::string tuning_device_key() {
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    const char *version = (const char *) glGetString(GL_VERSION);
+    return std::string(renderer ? renderer : "unknown renderer") + " | " + (version ? version : "unknown version");
+}
+
+/**
+ * Reads a profile file, which consists of one section per device:
+ * a line "[device key]" followed by lines "name = value".
+ * @return (device key, lines of the section) for every section, empty if the file doesn't exist
+ */
+inline std::vector<std::pair<std::string, std::vector<std::string>>> read_tuning_sections(const std::string &path) {
+    std::vector<std::pair<std::string, std::vector<std::string>>> sections;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.size() >= 2 && line.front() == '[' && line.back() == ']') {
+            sections.emplace_back(line.substr(1, line.size() - 2), std::vector<std::string>());
+        } else if (!sections.empty() && !line.empty() && line[0] != '#') {
+            sections.back().second.push_back(line);
+        }
+    }
+    return sections;
+}
+
+/**
+ * Loads the profile of the current device, needs a current OpenGL context.
+ * @return false if the file has no section for the device, profile is left unchanged then
+ */
+inline bool load_tuning_profile(TuningProfile &profile, const std::string &path = TUNING_PROFILE_PATH) {
+    const std::string key = tuning_device_key();
+    for (const auto &section: read_tuning_sections(path)) {
+        if (section.first != key) continue;
+        for (const std::string &line: section.second) {
+            std::string::size_type separator = line.find('=');
+            if (separator == std::string::npos) continue;
+            std::string name = line.substr(0, line.find_last_not_of(' ', separator - 1) + 1);
+            int value = std::atoi(line.c_str() + separator + 1);
+            if (name == "local_size") profile.local_size = value;
+            else if (name == "tile_size") profile.tile_size = value;
+            else if (name == "use_grid") profile.use_grid = value != 0;
+            else if (name == "num_particles") profile.num_particles = value;
+        }
+        return true;
+    }
+    return false;
+}
+
+// stores the profile of the current device, the sections of other devices are kept
+inline void save_tuning_profile(const TuningProfile &profile, const std::string &path = TUNING_PROFILE_PATH) {
+    const std::string key = tuning_device_key();
+    std::vector<std::pair<std::string, std::vector<std::string>>> sections = read_tuning_sections(path);
+
+    std::vector<std::string> lines{
+            "local_size = " + std::to_string(profile.local_size),
+            "tile_size = " + std::to_string(profile.tile_size),
+            "use_grid = " + std::to_string((int) profile.use_grid),
+            "num_particles = " + std::to_string(profile.num_particles)
+    };
+    bool replaced = false;
+    for (auto &section: sections) {
+        if (section.first == key) {
+            section.second = lines;
+            replaced = true;
+        }
+    }
+    if (!replaced) sections.emplace_back(key, lines);
+
+    std::ofstream file(path);
+    file << "# written by autotune, one section per GL_RENDERER | GL_VERSION\n";
+    for (const auto &section: sections) {
+        file << '[' << section.first << "]\n";
+        for (const std::string &line: section.second) file << line << '\n';
+    }
+    if (!file) std::cerr << "failed to write the tuning profile " << path << std::endl;
+}
+
+#endif //PARTICLE_LENIA_TUNING_PROFILE_HPP